@@ -0,0 +1,69 @@
+// Micro and level benchmarks, build in release mode and run "bench [name...]"
+#define GL3W_IMPLEMENTATION
+#include <gl3w.h>
+
+#include <cstring>
+#include <iostream>
+
+#include "bench.hpp"
+#include "map_generator.hpp"
+#include "world_init.hpp"
+
+volatile uint64_t bench_sink = 0;
+
+bool load_level(int level)
+{
+	static MapGenerator map_generator;
+	static bool initialized = false;
+	if (!initialized) {
+		// No renderer, the benchmarks never look at meshes
+		map_generator.init(nullptr);
+		registry.game_state.emplace(Entity());
+		createPlayer();
+		initialized = true;
+	}
+	// Loading logs every entity it creates, keep that out of the tables
+	std::streambuf* out = std::cout.rdbuf(nullptr);
+	map_generator.load((LEVEL_ASSET_ID)((int)LEVEL_ASSET_ID::LEVEL_1 + level - 1));
+	registry.flush_commands();
+	std::cout.rdbuf(out);
+	std::cout.clear();
+	if (registry.maps.size() == 0) {
+		std::cerr << "Could not load level " << level << std::endl;
+		return false;
+	}
+	return true;
+}
+
+namespace {
+	struct Benchmark {
+		const char* name;
+		void (*run)();
+	};
+
+	const Benchmark benchmarks[] = {
+		{ "storage", bench_component_storage },
+		{ "views", bench_views },
+		{ "pathing", bench_pathing },
+		{ "firechain", bench_fire_chain },
+		{ "broadphase", bench_broadphase },
+		{ "aabb", bench_aabb_tests },
+		{ "sprites", bench_sprite_batches },
+	};
+}
+
+// Runs the named benchmarks in the given order, or all of them without arguments
+int main(int argc, char* argv[])
+{
+	for (const Benchmark& benchmark : benchmarks) {
+		bool selected = argc < 2;
+		for (int i = 1; i < argc; i++)
+			selected |= std::strcmp(argv[i], benchmark.name) == 0;
+		if (!selected) continue;
+
+		std::cout << "== " << benchmark.name << std::endl;
+		benchmark.run();
+		std::cout << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+#include <stdint.h>
+
+// Results are added here so the compiler cannot drop the measured work
+extern volatile uint64_t bench_sink;
+
+// Runs f until at least min_ms have passed and returns the mean milliseconds of one run
+template <typename F>
+double time_ms(F&& f, double min_ms = 200.0)
+{
+	using clock = std::chrono::steady_clock;
+	f(); // warm up caches and allocations
+	int runs = 0;
+	auto start = clock::now();
+	double elapsed = 0.0;
+	do {
+		f();
+		runs++;
+		elapsed = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+	} while (elapsed < min_ms);
+	return elapsed / runs;
+}
+
+// Times a and b in alternating rounds and returns the fastest round of each, so that a slow phase of a busy
+// machine does not land on only one side of a comparison
+template <typename A, typename B>
+std::pair<double, double> time_ms_pair(A&& a, B&& b, int rounds = 7)
+{
+	double best_a = 1e300, best_b = 1e300;
+	for (int i = 0; i < rounds; i++) {
+		best_a = std::min(best_a, time_ms(a, 30.0));
+		best_b = std::min(best_b, time_ms(b, 30.0));
+	}
+	return { best_a, best_b };
+}
+
+// Loads data/levels/level_<level>.json into the registry like a headless run, returns false if that failed
+bool load_level(int level);
+
+// Benchmarks, each prints a small table to stdout
+void bench_component_storage();
+void bench_views();
+void bench_pathing();
+void bench_fire_chain();
+void bench_broadphase();
+void bench_aabb_tests();
+void bench_sprite_batches();
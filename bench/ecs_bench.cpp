@@ -0,0 +1,168 @@
+// Component storage: the paged sparse set of ComponentContainer against the hash map it replaced
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+
+#include "tinyECS/components.hpp"
+#include "tinyECS/registry.hpp"
+#include "tinyECS/tiny_ecs.hpp"
+#include "bench.hpp"
+
+namespace {
+	// The entity -> index part of ComponentContainer before the sparse set, trimmed to what is measured
+	template <typename Component>
+	class HashMapContainer
+	{
+		std::unordered_map<unsigned int, unsigned int> map_entity_componentID;
+
+	public:
+		std::vector<Component> components;
+		std::vector<Entity> entities;
+
+		Component& insert(Entity e, Component c) {
+			map_entity_componentID[e] = (unsigned int)components.size();
+			components.push_back(std::move(c));
+			entities.push_back(e);
+			return components.back();
+		}
+
+		Component& get(Entity e) { return components[map_entity_componentID[e]]; }
+
+		bool has(Entity e) { return map_entity_componentID.count(e) > 0; }
+
+		void remove(Entity e) {
+			if (!has(e)) return;
+			unsigned int cID = map_entity_componentID[e];
+			components[cID] = std::move(components.back());
+			entities[cID] = entities.back();
+			map_entity_componentID[entities.back()] = cID;
+			map_entity_componentID.erase(e);
+			components.pop_back();
+			entities.pop_back();
+		}
+	};
+
+	struct StorageTimes {
+		double churn_ns;		// one insert plus one remove
+		double ordered_ns;		// has() and get() in container order, like iterating one container and reading another
+		double shuffled_ns;		// has() and get() in random order, like following Collision::other
+	};
+
+	template <typename Container>
+	StorageTimes time_storage(const std::vector<Entity>& entities, const std::vector<Entity>& shuffled) {
+		const double n = (double)entities.size();
+		StorageTimes times;
+
+		times.churn_ns = time_ms([&]() {
+			Container container;
+			for (Entity e : entities)
+				container.insert(e, Motion());
+			for (Entity e : shuffled)
+				container.remove(e);
+			bench_sink = bench_sink + container.components.size();
+		}) * 1e6 / n;
+
+		Container container;
+		for (Entity e : entities)
+			container.insert(e, Motion());
+		auto read_all = [&container](const std::vector<Entity>& order) {
+			float sum = 0.f;
+			for (Entity e : order)
+				if (container.has(e))
+					sum += container.get(e).position.x;
+			bench_sink = bench_sink + (uint64_t)sum;
+		};
+		times.ordered_ns = time_ms([&]() { read_all(entities); }) * 1e6 / n;
+		times.shuffled_ns = time_ms([&]() { read_all(shuffled); }) * 1e6 / n;
+		return times;
+	}
+}
+
+void bench_component_storage()
+{
+	std::printf("%9s  %-10s %12s %12s %12s\n", "entities", "storage", "ins+rm ns", "ordered ns", "shuffled ns");
+	for (int count : { 1000, 10000, 100000 }) {
+		std::vector<Entity> entities(count);
+		std::vector<Entity> shuffled = entities;
+		std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(42));
+
+		StorageTimes hash = time_storage<HashMapContainer<Motion>>(entities, shuffled);
+		StorageTimes sparse = time_storage<ComponentContainer<Motion>>(entities, shuffled);
+		std::printf("%9d  %-10s %12.1f %12.1f %12.1f\n", count, "hash map", hash.churn_ns, hash.ordered_ns, hash.shuffled_ns);
+		std::printf("%9d  %-10s %12.1f %12.1f %12.1f\n", count, "sparse set", sparse.churn_ns, sparse.ordered_ns, sparse.shuffled_ns);
+
+		for (Entity e : entities)
+			Entity::release(e);
+	}
+}
+
+namespace {
+	// Reads the components of every entity a RenderSystem::draw loop visits, the way the loops did before views
+	template <typename Component>
+	float draw_loop_lookups(ComponentContainer<Component>& drawn)
+	{
+		float sum = 0.f;
+		for (Entity entity : drawn.entities) {
+			if (registry.motions.has(entity) && registry.renderRequests.has(entity)) {
+				Motion& motion = registry.motions.get(entity);
+				RenderRequest& render_request = registry.renderRequests.get(entity);
+				sum += motion.position.x + (float)render_request.used_effect;
+			}
+		}
+		return sum;
+	}
+
+	template <typename Component>
+	float draw_view_lookups()
+	{
+		float sum = 0.f;
+		for (auto [entity, drawn, motion, render_request] : registry.view<Component, Motion, RenderRequest>())
+			sum += motion.position.x + (float)render_request.used_effect;
+		return sum;
+	}
+}
+
+void bench_views()
+{
+	std::printf("%5s  %-8s %14s %14s\n", "level", "system", "has/get ns", "view ns");
+	for (int level : { 3, 6 }) {
+		if (!load_level(level)) return;
+
+		auto [draw_lookups, draw_views] = time_ms_pair(
+			[]() {
+				float sum = draw_loop_lookups(registry.wallBlocks) + draw_loop_lookups(registry.ingredients) +
+							draw_loop_lookups(registry.powerups) + draw_loop_lookups(registry.meshPtrs) +
+							draw_loop_lookups(registry.enemies) + draw_loop_lookups(registry.fireBlocks) +
+							draw_loop_lookups(registry.players);
+				bench_sink = bench_sink + (uint64_t)sum;
+			},
+			[]() {
+				float sum = draw_view_lookups<WallBlock>() + draw_view_lookups<Ingredient>() + draw_view_lookups<Powerup>() +
+							draw_view_lookups<Mesh*>() + draw_view_lookups<Enemy>() + draw_view_lookups<FireBlock>() +
+							draw_view_lookups<Player>();
+				bench_sink = bench_sink + (uint64_t)sum;
+			});
+
+		// AISystem::step
+		auto [ai_lookups, ai_views] = time_ms_pair(
+			[]() {
+				float sum = 0.f;
+				for (Entity enemy_entity : registry.enemies.entities) {
+					Enemy& enemy = registry.enemies.get(enemy_entity);
+					PathFinding& pf = registry.pathfindings.get(enemy_entity);
+					sum += pf.speed + (float)enemy.type;
+				}
+				bench_sink = bench_sink + (uint64_t)sum;
+			},
+			[]() {
+				float sum = 0.f;
+				for (auto [enemy_entity, enemy, pf] : registry.view<Enemy, PathFinding>())
+					sum += pf.speed + (float)enemy.type;
+				bench_sink = bench_sink + (uint64_t)sum;
+			});
+
+		std::printf("%5d  %-8s %14.0f %14.0f\n", level, "render", draw_lookups * 1e6, draw_views * 1e6);
+		std::printf("%5d  %-8s %14.0f %14.0f\n", level, "ai", ai_lookups * 1e6, ai_views * 1e6);
+	}
+}
@@ -0,0 +1,217 @@
+// Enemy pathfinding on the shipped levels: the pooled PathSearch against the A* it replaced and the flow field,
+// and the flow field's incremental repair against rebuilding it or searching again while a fire chain spreads and
+// burns out
+#include <cstdio>
+#include <map>
+#include <queue>
+#include <random>
+#include <set>
+#include <tuple>
+
+#include "pathing.hpp"
+#include "tinyECS/registry.hpp"
+#include "bench.hpp"
+
+namespace {
+	// Same passability rule as AISystem::isOccupied
+	bool isOccupied(ivec2 pos) {
+		return registry.grid.any({ pos.x, pos.y }, BLOCKING_GRID_LAYERS);
+	}
+
+	// AISystem::findPathToPlayer before PathSearch, trimmed to what is measured. The original never freed its
+	// nodes, they are deleted here so that the benchmark does not run out of memory.
+	std::vector<ivec2> map_find_path(ivec2 start, ivec2 goal, bool (*isCellOccupied)(ivec2 position)) {
+		struct Node {
+			ivec2 position, parent;
+			uint G, F;
+		};
+		struct CompareIvec2 {
+			bool operator()(const ivec2& a, const ivec2& b) const { return std::tie(a.x, a.y) < std::tie(b.x, b.y); }
+		};
+		auto compare_nodes = [](Node* a, Node* b) { return a->F > b->F; };
+		std::priority_queue<Node*, std::vector<Node*>, decltype(compare_nodes)> open_list(compare_nodes);
+		std::map<ivec2, Node*, CompareIvec2> best_path_so_far;
+		std::set<ivec2, CompareIvec2> visited;
+		std::vector<Node*> allocated;
+
+		auto new_node = [&allocated](ivec2 position, ivec2 parent, uint g, uint h) {
+			allocated.push_back(new Node{ position, parent, g, g + h });
+			return allocated.back();
+		};
+
+		std::vector<ivec2> path;
+		Node* start_node = new_node(start, ivec2(-1, -1), 0, abs(start.x - goal.x) + abs(start.y - goal.y));
+		open_list.push(start_node);
+		best_path_so_far[start] = start_node;
+
+		while (!open_list.empty()) {
+			Node* current = open_list.top();
+			open_list.pop();
+			if (visited.find(current->position) != visited.end()) continue;
+
+			if (current->position == goal) {
+				while (current->parent.x != -1) {
+					path.push_back(current->position);
+					current = best_path_so_far[current->parent];
+				}
+				path.push_back(start);
+				break;
+			}
+
+			for (ivec2 dir : { ivec2(-1, 0), ivec2(1, 0), ivec2(0, -1), ivec2(0, 1) }) {
+				ivec2 neighbor_pos = current->position + dir;
+				if (isCellOccupied(neighbor_pos) || visited.find(neighbor_pos) != visited.end()) continue;
+
+				uint g = current->G + 1;
+				uint h = abs(neighbor_pos.x - goal.x) + abs(neighbor_pos.y - goal.y);
+				auto best = best_path_so_far.find(neighbor_pos);
+				if (best == best_path_so_far.end() || g < best->second->G) {
+					Node* neighbor = new_node(neighbor_pos, current->position, g, h);
+					best_path_so_far[neighbor_pos] = neighbor;
+					open_list.push(neighbor);
+				}
+			}
+			visited.insert(current->position);
+		}
+
+		for (Node* node : allocated)
+			delete node;
+		return path;
+	}
+
+	ivec2 player_cell() {
+		return position_to_grid_coords_ivec2(registry.motions.get(registry.players.entities[0]).position);
+	}
+}
+
+void bench_pathing()
+{
+	std::printf("%5s %7s %8s  %14s %14s %14s\n", "level", "cells", "path len", "map A* /s", "pooled A* /s", "field /s");
+	for (int level = 1; level <= 6; level++) {
+		if (!load_level(level)) return;
+		ivec2 goal = player_cell();
+
+		// Searches start from random free cells that can reach the player, like enemies spread over the map
+		FlowField field(isOccupied);
+		field.update(goal);
+		std::vector<ivec2> reachable;
+		for (int y = 0; y < registry.grid.rows(); y++)
+			for (int x = 0; x < registry.grid.cols(); x++)
+				if (field.distanceAt({ x, y }) != FlowField::UNREACHABLE && ivec2(x, y) != goal)
+					reachable.push_back({ x, y });
+		if (reachable.empty()) continue;
+		std::mt19937 rng(level);
+		std::vector<ivec2> starts;
+		double path_length = 0.0;
+		for (int i = 0; i < 64; i++) {
+			starts.push_back(reachable[rng() % reachable.size()]);
+			path_length += field.distanceAt(starts.back());
+		}
+		path_length /= (double)starts.size();
+
+		double map_ms = time_ms([&]() {
+			for (ivec2 start : starts)
+				bench_sink = bench_sink + map_find_path(start, goal, isOccupied).size();
+		});
+		PathSearch search;
+		std::vector<ivec2> path;
+		double pooled_ms = time_ms([&]() {
+			for (ivec2 start : starts) {
+				search.findPath(start, goal, isOccupied, path);
+				bench_sink = bench_sink + path.size();
+			}
+		});
+		// Moving the target between two cells makes every update a full rebuild, like the player changing cell
+		ivec2 other_goal = reachable[0];
+		bool at_goal = false;
+		double field_ms = time_ms([&]() {
+			at_goal = !at_goal;
+			field.update(at_goal ? goal : other_goal);
+			bench_sink = bench_sink + field.distanceAt(starts[0]);
+		});
+
+		double searches = (double)starts.size();
+		std::printf("%5d %7d %8.1f  %14.0f %14.0f %14.0f\n", level, registry.grid.rows() * registry.grid.cols(), path_length,
+					searches * 1000.0 / map_ms, searches * 1000.0 / pooled_ms, 1000.0 / field_ms);
+	}
+}
+
+void bench_fire_chain()
+{
+	std::printf("%5s %6s  %16s %16s %16s\n", "level", "chain", "repair us/change", "rebuild us/change", "A* us/change");
+	for (int level : { 3, 5, 6 }) {
+		if (!load_level(level)) return;
+		ivec2 goal = player_cell();
+
+		// The chain spreads breadth-first from a free cell far from the player, one cell per change, the way
+		// fire blocks spawn their neighbors. It covers every free cell it can reach except the player's.
+		FlowField field(isOccupied);
+		field.update(goal);
+		ivec2 origin = goal;
+		for (int y = 0; y < registry.grid.rows(); y++)
+			for (int x = 0; x < registry.grid.cols(); x++)
+				if (field.distanceAt({ x, y }) != FlowField::UNREACHABLE && field.distanceAt({ x, y }) > field.distanceAt(origin))
+					origin = { x, y };
+		// A lone chaser halfway between the origin and the player, the chain goes around its cell
+		ivec2 chaser = origin;
+		for (int y = 0; y < registry.grid.rows(); y++)
+			for (int x = 0; x < registry.grid.cols(); x++)
+				if (field.distanceAt({ x, y }) == field.distanceAt(origin) / 2)
+					chaser = { x, y };
+		std::vector<ivec2> chain = { origin };
+		std::vector<bool> queued((size_t)registry.grid.rows() * registry.grid.cols(), false);
+		queued[origin.y * registry.grid.cols() + origin.x] = true;
+		queued[chaser.y * registry.grid.cols() + chaser.x] = true;
+		for (size_t head = 0; head < chain.size(); head++) {
+			for (ivec2 dir : { ivec2(-1, 0), ivec2(1, 0), ivec2(0, -1), ivec2(0, 1) }) {
+				ivec2 next = chain[head] + dir;
+				if (next == goal || isOccupied(next) || queued[next.y * registry.grid.cols() + next.x]) continue;
+				queued[next.y * registry.grid.cols() + next.x] = true;
+				chain.push_back(next);
+			}
+		}
+
+		// Spreads the whole chain and then extinguishes it from its start, calling replan after every change
+		Entity fire;
+		auto burn = [&chain, &fire, goal](auto&& replan) {
+			for (ivec2 cell : chain) {
+				registry.grid.set({ cell.x, cell.y }, GRID_LAYER::FIRE, fire);
+				replan();
+			}
+			for (ivec2 cell : chain) {
+				registry.grid.unset({ cell.x, cell.y }, GRID_LAYER::FIRE);
+				replan();
+			}
+			bench_sink = bench_sink + (uint64_t)goal.x;
+		};
+		// The chaser's next step after every change: read from the repaired or rebuilt field, or found by a new
+		// A* search from the chaser, as AISystem did for a rule's only chaser before it used the field for it too
+		auto repair = [&]() {
+			burn([&]() {
+				ivec2 next_step;
+				field.update(goal);
+				bench_sink = bench_sink + field.nextStep(chaser, next_step);
+			});
+		};
+		auto [repair_ms, rebuild_ms] = time_ms_pair(repair, [&]() {
+			burn([&]() {
+				ivec2 next_step;
+				FlowField fresh(isOccupied);
+				fresh.update(goal);
+				bench_sink = bench_sink + fresh.nextStep(chaser, next_step);
+			});
+		});
+		PathSearch search;
+		std::vector<ivec2> path;
+		auto [search_ms, repair_again_ms] = time_ms_pair([&]() {
+			burn([&]() {
+				bench_sink = bench_sink + search.findPath(chaser, goal, isOccupied, path);
+			});
+		}, repair);
+		Entity::release(fire);
+
+		double changes = 2.0 * (double)chain.size();
+		std::printf("%5d %6zu  %16.2f %16.2f %16.2f\n", level, chain.size(), std::min(repair_ms, repair_again_ms) * 1000.0 / changes,
+					rebuild_ms * 1000.0 / changes, search_ms * 1000.0 / changes);
+	}
+}
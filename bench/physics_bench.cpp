@@ -0,0 +1,122 @@
+// Collision pass: the uniform-grid broadphase of PhysicsSystem against testing every pair with collides(), and the
+// batched AABB test of the candidate pairs against collides()
+#include <cstdio>
+#include <random>
+
+#include "physics_system.hpp"
+#include "bench.hpp"
+
+namespace {
+	// About one body per map cell, like a crowded level scaled up. A third are walls on cell centers, the rest are
+	// enemies anywhere on the map with slightly smaller hitboxes.
+	void create_bodies(int count) {
+		int spread = 1;
+		while (spread * spread < count)
+			spread++;
+		std::mt19937 rng(count);
+		std::uniform_real_distribution<float> unit(0.f, 1.f);
+		std::uniform_int_distribution<int> cell(0, spread - 1);
+		for (int i = 0; i < count; i++) {
+			Entity entity;
+			Motion& motion = registry.motions.emplace(entity);
+			motion.collidable = true;
+			if (i % 3 == 0) {
+				motion.position = grid_coords_to_position(cell(rng), cell(rng));
+				motion.hitbox = { GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX };
+				motion.collision_layer = COLLISION_LAYER::OBSTACLE;
+				registry.staticBodies.emplace(entity);
+			} else {
+				motion.position = { unit(rng) * spread * GRID_CELL_WIDTH_PX, unit(rng) * spread * GRID_CELL_HEIGHT_PX };
+				motion.hitbox = { 0.8f * GRID_CELL_WIDTH_PX, 0.8f * GRID_CELL_HEIGHT_PX };
+				motion.collision_layer = COLLISION_LAYER::ENEMY;
+			}
+			motion.scale = motion.hitbox;
+		}
+	}
+
+	void clear_bodies() {
+		std::vector<Entity> entities = registry.motions.entities;
+		for (Entity e : entities)
+			registry.destroy_entity(e);
+		registry.collisions.clear();
+	}
+
+	// The collision pass before the broadphase
+	size_t all_pairs_hits() {
+		ComponentContainer<Motion>& motions = registry.motions;
+		size_t hits = 0;
+		for (size_t i = 0; i < motions.size(); i++)
+			for (size_t j = i + 1; j < motions.size(); j++)
+				hits += collides(motions.components[i], motions.components[j]);
+		return hits;
+	}
+}
+
+void bench_broadphase()
+{
+	std::printf("%9s %11s  %14s %14s %14s\n", "bodies", "collisions", "all pairs ms", "broadphase ms", "ns/body");
+	for (int count : { 1000, 10000, 50000 }) {
+		create_bodies(count);
+
+		PhysicsSystem physics;
+		size_t collisions = 0;
+		double broadphase_ms = time_ms([&]() {
+			registry.collisions.clear();
+			physics.step(0.f);
+			collisions = registry.collisions.size();
+		});
+		// Over ten seconds per run at 50k bodies, so a single run is timed there
+		double all_pairs_ms = time_ms([]() { bench_sink = bench_sink + all_pairs_hits(); }, 0.0);
+
+		std::printf("%9d %11zu  %14.2f %14.3f %14.1f\n", count, collisions, all_pairs_ms, broadphase_ms, broadphase_ms * 1e6 / count);
+		clear_bodies();
+	}
+}
+
+// Runs the stages of the collision pass on their own
+struct AABBBench {
+	PhysicsSystem physics;
+
+	size_t findCandidates() {
+		physics.findCandidatePairs();
+		return physics.candidate_pairs.size();
+	}
+
+	// Batched test over the packed AABBs, 4 pairs at a time with SSE
+	size_t testBatched() {
+		physics.testCandidateAABBs();
+		size_t hits = 0;
+		for (uint8_t hit : physics.candidate_hits)
+			hits += hit;
+		return hits;
+	}
+
+	// The same candidates through collides(), as the collision pass did before the batched test
+	size_t testScalar() {
+		ComponentContainer<Motion>& motions = registry.motions;
+		size_t hits = 0;
+		for (std::pair<uint, uint> candidate : physics.candidate_pairs)
+			hits += collides(motions.components[candidate.first], motions.components[candidate.second]);
+		return hits;
+	}
+};
+
+void bench_aabb_tests()
+{
+	std::printf("%9s %11s  %16s %16s\n", "bodies", "pairs", "collides() M/s", "batched M/s");
+	for (int count : { 1000, 10000, 50000 }) {
+		create_bodies(count);
+		AABBBench bench;
+		double pairs = (double)bench.findCandidates();
+
+		size_t scalar_hits = 0, batched_hits = 0;
+		auto [scalar_ms, batched_ms] = time_ms_pair(
+			[&]() { scalar_hits = bench.testScalar(); },
+			[&]() { batched_hits = bench.testBatched(); });
+		if (scalar_hits != batched_hits)
+			std::printf("hit counts differ: %zu vs %zu\n", scalar_hits, batched_hits);
+
+		std::printf("%9d %11.0f  %16.1f %16.1f\n", count, pairs, pairs / scalar_ms / 1000.0, pairs / batched_ms / 1000.0);
+		clear_bodies();
+	}
+}
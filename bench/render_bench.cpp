@@ -0,0 +1,108 @@
+// Sprite batching without a gl context: replays the draw order of RenderSystem::draw for the PLAYING screen on a
+// loaded level and counts the draw calls with one draw per sprite against one per run of batched sprites. The
+// batching rules come from utils/sprite_batch.hpp like in the renderer, the passes and their flushes are copied
+// from RenderSystem::draw, so the counts are estimates of what the renderer issues.
+#include <cstdio>
+#include <vector>
+
+#include "tinyECS/registry.hpp"
+#include "utils/sprite_batch.hpp"
+#include "bench.hpp"
+
+namespace {
+	// Counts what RenderSystem::queueSprite, flushSprites and the unbatched draws would issue. Runs are keyed by
+	// texture asset instead of gl texture, assets that share an atlas page can only merge further, so the batched
+	// count is an upper bound.
+	struct DrawCounter {
+		using Key = SpriteBatchKey<TEXTURE_ASSET_ID>;
+		std::vector<Key> queued;
+		std::vector<uint32_t> order;
+		int per_sprite = 0;	// draws when every sprite is its own draw call
+		int batched = 0;	// draws with sprite batching
+
+		void flush(bool any_order = false) {
+			orderSpriteBatch(queued, any_order, order);
+			forEachSpriteRun(queued, order, [this](size_t, size_t) { batched++; });
+			queued.clear();
+		}
+
+		// Like drawTexturedMesh
+		void draw(Entity entity) {
+			const RenderRequest& r = registry.renderRequests.get(entity);
+			per_sprite++;
+			if (isBatchedSprite(r)) {
+				queued.push_back({ r.used_effect, r.used_texture,
+								   usesNormalTexture(r) ? r.used_normal_texture : TEXTURE_ASSET_ID::TEXTURE_COUNT });
+				return;
+			}
+			flush();
+			batched++;
+		}
+
+		// Like drawBox
+		void drawBox() {
+			flush();
+			per_sprite++;
+			batched++;
+		}
+	};
+
+	template <typename Component>
+	void draw_all(DrawCounter& counter, ComponentContainer<Component>& drawn) {
+		for (Entity entity : drawn.entities)
+			if (registry.motions.has(entity) && registry.renderRequests.has(entity))
+				counter.draw(entity);
+	}
+
+	// The world and hud passes of RenderSystem::draw, without camera culling. The static layer, the instanced
+	// smoke and the text are drawn the same way with and without batching and are left out.
+	DrawCounter count_playing_draws() {
+		DrawCounter counter;
+		GameState& game_state = registry.game_state.components[0];
+
+		for (Entity entity : registry.ingredients.entities) {
+			if (!registry.motions.has(entity) || !registry.renderRequests.has(entity)) continue;
+			Stage* stage = registry.stages.try_get(entity);
+			if (stage == nullptr || stage->value == game_state.cur_stage)
+				counter.draw(entity);
+		}
+		counter.flush(true);
+
+		draw_all(counter, registry.powerups);
+		for (Entity entity : registry.meshPtrs.entities)
+			if (registry.motions.has(entity) && registry.renderRequests.has(entity) &&
+				registry.renderRequests.get(entity).used_effect == EFFECT_ASSET_ID::MESH)
+				counter.draw(entity);
+		draw_all(counter, registry.enemies);
+		counter.flush();
+
+		draw_all(counter, registry.fireBlocks);
+		counter.flush(true);
+
+		draw_all(counter, registry.players);
+		counter.flush();
+
+		for (Entity e : registry.highlightBlocks.entities)
+			counter.draw(e);
+		counter.flush();
+
+		for (Entity e : registry.hud.entities) {
+			if (registry.boxes.has(e))
+				counter.drawBox();
+			else if (registry.motions.has(e))
+				counter.draw(e);
+		}
+		counter.flush();
+		return counter;
+	}
+}
+
+void bench_sprite_batches()
+{
+	std::printf("%5s %8s  %16s %16s\n", "level", "fires", "per-sprite draws", "batched draws");
+	for (int level = 1; level <= 6; level++) {
+		if (!load_level(level)) return;
+		DrawCounter counter = count_playing_draws();
+		std::printf("%5d %8zu  %16d %16d\n", level, registry.fireBlocks.size(), counter.per_sprite, counter.batched);
+	}
+}
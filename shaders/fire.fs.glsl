@@ -2,13 +2,13 @@
 
 // From vertex shader
 in vec2 texcoord;
-in float scale;
+flat in float scale;
+flat in vec4 fcolor;
+flat in vec4 uv_rect;
 // in float intensity;
 
 // Application data
 uniform sampler2D sampler0;
-uniform vec4 fcolor;
-uniform uint object_id;
 
 // Outputs
 layout (location = 0) out vec4 color;			// color
@@ -22,7 +22,12 @@ vec2 scale_uvs(vec2 uv, float scale) {
 
 void main() {
     // Preserve visual size of sprite
-	vec4 texColor = texture(sampler0, scale_uvs(texcoord, scale));
+	// Outside of its rect the texture is transparent, as a texture of its own clamped to a clear border would be
+	vec2 uv = scale_uvs(texcoord, scale);
+	vec4 texColor = vec4(0.0);
+	if (all(greaterThanEqual(uv, vec2(0.0))) && all(lessThanEqual(uv, vec2(1.0)))) {
+		texColor = texture(sampler0, uv_rect.xy + uv * uv_rect.zw);
+	}
 	color = fcolor * texColor;
 
     vec2 diff = texcoord - vec2(0.5, 0.5);
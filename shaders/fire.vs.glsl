@@ -1,26 +1,27 @@
 #version 330
 
-// Input attributes
-in vec3 in_position;
-in vec2 in_texcoord;
+// Input attributes, sprites are batched so positions are already transformed (and scaled by the light radius)
+layout (location = 0) in vec3 in_position;
+layout (location = 1) in vec2 in_texcoord;
+layout (location = 3) in vec4 in_fcolor;
+layout (location = 4) in float in_scale;
+layout (location = 6) in vec4 in_uv_rect;		// of the texture in its atlas page
 
 // Passed to fragment shader
 out vec2 texcoord;
-out float scale;
+flat out float scale;
+flat out vec4 fcolor;
+flat out vec4 uv_rect;
 
 // Application data
-uniform mat3 transform;
 uniform mat3 projection;
-uniform float u_scale;
 
 void main() {
 	texcoord = in_texcoord;
-    
-    mat3 transform_scaled = transform;
-    scale = u_scale;
-    transform_scaled[0][0] *= scale;
-    transform_scaled[1][1] *= scale;
+	scale = in_scale;
+	fcolor = in_fcolor;
+	uv_rect = in_uv_rect;
 
-	vec3 pos = projection * transform_scaled * vec3(in_position.xy, 1.0);
+	vec3 pos = projection * vec3(in_position.xy, 1.0);
 	gl_Position = vec4(pos.xy, in_position.z, 1.0);
-}
\ No newline at end of file
+}
@@ -15,6 +15,7 @@ out vec2 texcoord;
 out float alpha;
 
 uniform mat3 projection;
+uniform vec4 uv_rect;	// of the texture in its atlas page
 
 void main() {
     // Reconstruct mat3 from vec3 inputs
@@ -31,6 +32,6 @@ void main() {
     // Convert vec3 -> vec4 (OpenGL requires vec4 for gl_Position)
     gl_Position = vec4(projectedPos.xy, 0.0, 1.0);
     
-    texcoord = aTexCoord;
+    texcoord = uv_rect.xy + aTexCoord * uv_rect.zw;
     alpha = instance_alpha;
 }
@@ -3,12 +3,12 @@
 // From vertex shader
 in vec2 texcoord;
 in vec3 vertColor;
+flat in vec4 fcolor;
+flat in uint object_id;
 
 // Application data
 uniform sampler2D sampler0;
-uniform vec4 fcolor;
 uniform float time;
-uniform uint object_id;
 
 // Outputs
 layout (location = 0) out vec4 color;			// color
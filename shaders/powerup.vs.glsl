@@ -1,22 +1,28 @@
 #version 330
 
-// Input attributes
-in vec3 in_position;
-in vec2 in_texcoord;
-in vec3 in_color;
+// Input attributes, sprites are batched so positions are already transformed to world (or screen) space
+layout (location = 0) in vec3 in_position;
+layout (location = 1) in vec2 in_texcoord;
+layout (location = 2) in vec3 in_color;
+layout (location = 3) in vec4 in_fcolor;
+layout (location = 5) in uint in_object_id;
+layout (location = 6) in vec4 in_uv_rect;		// of the texture in its atlas page
 
 // Passed to fragment shader
 out vec2 texcoord;
 out vec3 vertColor;
+flat out vec4 fcolor;
+flat out uint object_id;
 
 // Application data
-uniform mat3 transform;
 uniform mat3 projection;
 
 void main()
 {
-	texcoord = in_texcoord;
+	texcoord = in_uv_rect.xy + in_texcoord * in_uv_rect.zw;
     vertColor = in_color;
-	vec3 pos = projection * transform * vec3(in_position.xy, 1.0);
+	fcolor = in_fcolor;
+	object_id = in_object_id;
+	vec3 pos = projection * vec3(in_position.xy, 1.0);
 	gl_Position = vec4(pos.xy, in_position.z, 1.0);
-}
\ No newline at end of file
+}
@@ -0,0 +1,26 @@
+#version 330
+
+// From vertex shader
+in vec2 texcoord;
+
+// Application data
+uniform sampler2D static_color;
+uniform sampler2D static_position;
+uniform sampler2D static_normal;
+
+// Outputs, the same targets the textured shader writes
+layout (location = 0) out vec4 color;			// color
+layout (location = 1) out uint out_object_id;	// object ID
+layout (location = 2) out vec3 position;		// world-space position
+layout (location = 3) out vec3 normal;			// normals
+
+void main()
+{
+	color = texture(static_color, texcoord);
+	// Nothing was drawn here when the layer was baked
+	if (color.a == 0.0) discard;
+
+	out_object_id = uint(0);
+	position = texture(static_position, texcoord).xyz;
+	normal = texture(static_normal, texcoord).xyz;
+}
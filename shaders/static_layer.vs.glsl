@@ -0,0 +1,19 @@
+#version 330
+
+// Input attributes
+in vec3 in_position;
+
+// Passed to fragment shader
+out vec2 texcoord;
+
+// Application data
+uniform mat3 transform;
+uniform mat3 projection;
+
+void main()
+{
+	// The layer was baked with the top of the world in the last row of the textures
+	texcoord = vec2(in_position.x + 0.5, 0.5 - in_position.y);
+	vec3 pos = projection * transform * vec3(in_position.xy, 1.0);
+	gl_Position = vec4(pos.xy, in_position.z, 1.0);
+}
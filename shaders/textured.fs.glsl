@@ -3,13 +3,14 @@
 // From vertex shader
 in vec3 v_position;
 in vec2 texcoord;
+in vec2 normal_texcoord;
+flat in vec4 fcolor;
+flat in float normal_strength;
+flat in uint object_id;
 
 // Application data
-uniform float normal_strength;
 uniform sampler2D color_sampler;
 uniform sampler2D normal_sampler;
-uniform vec4 fcolor;
-uniform uint object_id;
 
 // Outputs
 layout (location = 0) out vec4 color;			// color
@@ -23,7 +24,7 @@ void main() {
 
 	position = v_position;
 
-	vec4 normal_color = texture(normal_sampler, texcoord);
+	vec4 normal_color = texture(normal_sampler, normal_texcoord);
 	if (normal_strength > 0.0 && normal_color.a > 0.0) {
 		// apply normal strength by blending between identity normal
 		normal = mix(vec3(0.486, 0.482, 0.894), normal_color.rgb, normal_strength);
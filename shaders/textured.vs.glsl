@@ -1,24 +1,35 @@
 #version 330
 
-// Input attributes
-in vec3 in_position;
-in vec2 in_texcoord;
+// Input attributes, sprites are batched so positions are already transformed to world (or screen) space
+layout (location = 0) in vec3 in_position;
+layout (location = 1) in vec2 in_texcoord;
+layout (location = 3) in vec4 in_fcolor;
+layout (location = 4) in float in_normal_strength;
+layout (location = 5) in uint in_object_id;
+layout (location = 6) in vec4 in_uv_rect;			// of the textures in their atlas pages
+layout (location = 7) in vec4 in_normal_uv_rect;
 
 // Passed to fragment shader
 out vec3 v_position;
 out vec2 texcoord;
-out vec3 tempColor;
+out vec2 normal_texcoord;
+flat out vec4 fcolor;
+flat out float normal_strength;
+flat out uint object_id;
 
 // Application data
-uniform mat3 transform;
 uniform mat3 projection;
 
 void main()
 {
-	vec3 world_pos = transform * vec3(in_position.xy, 1.0);
+	vec3 world_pos = vec3(in_position.xy, 1.0);
 	vec3 pos = projection * world_pos;
 	gl_Position = vec4(pos.xy, in_position.z, 1.0);
 
 	v_position = world_pos;
-	texcoord = in_texcoord;
-}
\ No newline at end of file
+	texcoord = in_uv_rect.xy + in_texcoord * in_uv_rect.zw;
+	normal_texcoord = in_normal_uv_rect.xy + in_texcoord * in_normal_uv_rect.zw;
+	fcolor = in_fcolor;
+	normal_strength = in_normal_strength;
+	object_id = in_object_id;
+}
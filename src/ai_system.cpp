@@ -1,10 +1,8 @@
 #include "ai_system.hpp"
 #include "common.hpp"
 #include "tinyECS/registry.hpp"
-#include "pathing.hpp"
+#include "utils/profiler.hpp"
 
-#include <queue>
-#include <map>
 #include <vector>
 
 vec2 AISystem::getRandomDirection() {
@@ -32,13 +30,12 @@ void AISystem::handleEnemyObstacleCollision(Entity& enemy_entity) {
 
         vec2 snap_pos = snap_position_to_grid(motion.position);
         std::pair<int, int> snap_cell = position_to_grid_coords(snap_pos);
-        std::optional<Entity> snap_entity = registry.map_grid_coord_entityID[snap_cell];
         
         // Edge case: if the obstacle was dynamically placed just before the
         // position of this Enemy was updated (in the physics loop) to be in the obstacle's cell,
         // the Enemy would be snapped to the obstacle's cell.
         // So, set the position to the cell that the Enemy was previously in
-        if (snap_entity.has_value() && registry.obstacles.has(snap_entity.value())) {
+        if (registry.grid.any(snap_cell, BLOCKING_GRID_LAYERS)) {
             int x_offset = 0;
             int y_offset = 0;
             if (motion.velocity.x != 0) { x_offset = (motion.velocity.x > 0) ? -1 : 1; }
@@ -74,83 +71,16 @@ void AISystem::handleIngredientObstacleCollision(Entity& ingredient_entity) {
 }
 
 bool AISystem::isOccupied(ivec2 pos) {
-    std::pair<int, int> grid_pos = std::make_pair(pos.x, pos.y);
-    std::optional<Entity> e = registry.map_grid_coord_entityID[grid_pos];
-
-    return e.has_value() && (registry.obstacles.has(e.value()));
+    return registry.grid.any({ pos.x, pos.y }, BLOCKING_GRID_LAYERS);
 }
 bool AISystem::isOccupiedSansFire(ivec2 pos) {
-    std::pair<int, int> grid_pos = std::make_pair(pos.x, pos.y);
-    std::optional<Entity> e = registry.map_grid_coord_entityID[grid_pos];
-
-    return e.has_value() && ((registry.obstacles.has(e.value()) && !registry.fireBlocks.has(e.value())));
-}
-
-std::vector<ivec2> AISystem::findPathToPlayer(ivec2 start, ivec2 goal, bool (*isCellOccupied)(ivec2 position)) {
-    std::vector<ivec2> path;
-    auto compare_nodes = [](Node* a, Node* b) { return a->F > b->F; };
-    std::priority_queue<Node*, std::vector<Node*>, decltype(compare_nodes)> open_list(compare_nodes);
-
-    struct CompareIvec2 {
-        bool operator()(const glm::ivec2& a, const glm::ivec2& b) const {
-            return std::tie(a.x, a.y) < std::tie(b.x, b.y);
-        }
-    };
-
-    std::map<glm::ivec2, Node*, CompareIvec2> best_path_so_far;
-    std::set<glm::ivec2, CompareIvec2> visited;
-
-    Node* start_node = new Node(start, glm::ivec2(-1, -1), 0, abs(start.x - goal.x) + abs(start.y - goal.y));
-    open_list.push(start_node);
-    best_path_so_far[start] = start_node;
-
-
-    while (!open_list.empty()) {
-        Node* current = open_list.top();
-        open_list.pop();
-
-        if (visited.find(current->position) != visited.end()) {
-            continue;
-        }
-
-        if (current->position == goal) {
-
-            while (current->parent.x != -1) {
-                path.push_back(current->position);
-                current = best_path_so_far[current->parent];
-            }
-            path.push_back(start);
-      
-            return path;
-        }
-
-        for (ivec2 dir : possible_directions) {
-            ivec2 neighbor_pos = current->position + dir;
-
-            if (isCellOccupied(neighbor_pos) || visited.find(neighbor_pos) != visited.end()) continue;
-
-            uint g = current->G + 1;
-            uint h = abs(neighbor_pos.x - goal.x) + abs(neighbor_pos.y - goal.y);
-
-            if (best_path_so_far.find(neighbor_pos) == best_path_so_far.end() || g < best_path_so_far[neighbor_pos]->G) {
-                Node* neighbor = new Node(neighbor_pos, current->position, g, h);
-                best_path_so_far[neighbor_pos] = neighbor;
-                open_list.push(neighbor);
-                
-            }
-        }
-        visited.insert(current->position);
-    }
-
-   
-    return path;
+    return registry.grid.has({ pos.x, pos.y }, GRID_LAYER::OBSTACLE);
 }
 
 void AISystem::step(float elapsed_ms) {
+	PROFILE_SYSTEM_SCOPE("AISystem::step", PERF_SYSTEM::AI);
 
-    for (Entity enemy_entity : registry.enemies.entities) {
-        Enemy& enemy = registry.enemies.get(enemy_entity);
-        PathFinding& pf = registry.pathfindings.get(enemy_entity);
+    for (auto [enemy_entity, enemy, pf] : registry.view<Enemy, PathFinding>()) {
 
 		// handle enemy pathfinding timeout
         pf.path_update_timer -= elapsed_ms;
@@ -220,8 +150,7 @@ void AISystem::aStarFireStep(Entity& enemy_entity, float elapsed_sec) {
 
             enemy.direction = dir;
         
-            std::optional<Entity> cell_entity = registry.map_grid_coord_entityID[{ next_grid_pos.x, next_grid_pos.y }];
-            if (cell_entity.has_value() && registry.fireBlocks.has(cell_entity.value()) && enemy.fire_ready) {
+            if (registry.grid.has({ next_grid_pos.x, next_grid_pos.y }, GRID_LAYER::FIRE) && enemy.fire_ready) {
                 FireSystem::handleFireBlockChainInteraction(enemy_motion.position, dir, false, true);
                 enemy.fire_ready = false;
                 enemy.fire_interaction_timer = 500;
@@ -229,7 +158,7 @@ void AISystem::aStarFireStep(Entity& enemy_entity, float elapsed_sec) {
         }
 	};
 
-	aStarAbstractedStep(enemy_entity, elapsed_sec, isOccupiedSansFire, handleNoPath, handleNextStep);
+	aStarAbstractedStep(enemy_entity, elapsed_sec, fire_walking_field, handleNoPath, handleNextStep);
 }
 
 void AISystem::aStarStep(Entity& enemy_entity, float elapsed_sec) {
@@ -240,14 +169,14 @@ void AISystem::aStarStep(Entity& enemy_entity, float elapsed_sec) {
 	
 	auto handleNextStep = [](Enemy& enemy, Motion& enemy_motion, ivec2 next_grid_pos, ivec2 enemy_pos) {};
 
-    aStarAbstractedStep(enemy_entity, elapsed_sec, isOccupied, handleNoPath, handleNextStep);
+    aStarAbstractedStep(enemy_entity, elapsed_sec, walking_field, handleNoPath, handleNextStep);
 }
 
 
 void AISystem::aStarAbstractedStep(
 	Entity& enemy_entity, 
 	float elapsed_sec, 
-	bool (*isOccupied)(ivec2 position),
+	FlowField& field,
     std::function<void(Enemy&, ivec2)> handleNoPath,
 	void (*handleNextStep) (Enemy& enemy, Motion& enemy_motion, ivec2 next_grid_pos, ivec2 enemy_pos)
 ) {
@@ -261,11 +190,16 @@ void AISystem::aStarAbstractedStep(
     glm::ivec2 enemy_pos = position_to_grid_coords_ivec2(enemy_motion.position);
     glm::ivec2 player_pos = position_to_grid_coords_ivec2(player_motion.position);
 
-	std::vector<ivec2> new_path = findPathToPlayer(enemy_pos, player_pos, isOccupied);
-	
-	if (!new_path.empty()) {
-		pf.path = new_path;
-		pf.path.pop_back();
+	// Only rebuilt when the player changed cell or an obstacle/fire cell changed
+	field.update(player_pos);
+
+	ivec2 next_step;
+	if (enemy_pos == player_pos || field.nextStep(enemy_pos, next_step)) {
+		// The path only holds the next step, the field is read again next frame
+		pf.path.clear();
+		if (enemy_pos != player_pos) {
+			pf.path.push_back(next_step);
+		}
 		if (pf.type == PATHFINDING_ID::BOUNCE) {
 			pf.type = pf.original_pid;
 		}
@@ -4,6 +4,7 @@
 #include "common.hpp"
 #include "render_system.hpp"
 #include "fire_system.hpp"
+#include "pathing.hpp"
 #include "tinyECS/registry.hpp"
 
 class AISystem
@@ -25,7 +26,10 @@ private:
 		void (*handleNextStep) (Enemy& enemy, Motion& enemy_motion, ivec2 next_grid_pos, ivec2 enemy_pos)
 	);
 	
-	std::vector<ivec2> findPathToPlayer (ivec2 start, ivec2 goal, bool (*isCellOccupied)(ivec2 position));
+	// Distance fields toward the player, one per passability rule, shared by all chasing enemies. A lone chaser
+	// uses the field too: repairing it after a fire change costs less than a new A* search, see "bench firechain"
+	FlowField walking_field { isOccupied };
+	FlowField fire_walking_field { isOccupiedSansFire };
 	/*
 	* Travels in a straight line, changes direction when it hits an obstacle
 	* (TODO: refactor to move logic from handleEnemyObstacleCollision to bounceStep)
@@ -35,7 +39,7 @@ private:
 	void aStarAbstractedStep(
 		Entity& enemy_entity, 
 		float elapsed_sec, 
-		bool (*isCellOccupied)(ivec2 position),
+		FlowField& field,
 		std::function<void(Enemy&, ivec2)> handleNoPath,
 		void (*handleNextStep) (Enemy& enemy, Motion& enemy_motion, ivec2 next_grid_pos, ivec2 enemy_pos)
 	);
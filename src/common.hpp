@@ -3,6 +3,7 @@
 // stlib
 #include <fstream> // stdout, stderr..
 #include <string>
+#include <cstdlib>
 #include <cstring>
 #include <random>
 #include <tuple>
@@ -24,7 +25,7 @@ using namespace glm;
 
 // Simple utility functions to avoid mistyping directory name
 // audio_path("audio.ogg") -> data/audio/audio.ogg
-// Get defintion of PROJECT_SOURCE_DIR from:
+// Get defintion of PROJECT_SOURCE_DIR and PROJECT_BINARY_DIR from:
 #include "../ext/project_path.hpp"
 inline std::string data_path() { return std::string(PROJECT_SOURCE_DIR) + "data"; };
 inline std::string shader_path(const std::string& name) {return std::string(PROJECT_SOURCE_DIR) + "/shaders/" + name;};
@@ -34,10 +35,17 @@ inline std::string mesh_path(const std::string& name) {return data_path() + "/me
 inline std::string levels_path(const std::string& name) {return data_path() + "/levels/" + std::string(name);};
 inline std::string fonts_path(const std::string& name) {return data_path() + "/fonts/" + std::string(name);};
 inline std::string persistence_path(const std::string& name) {return data_path() + "/persistence/" + std::string(name);};
+inline std::string trace_path(const std::string& name) {return std::string(PROJECT_BINARY_DIR) + std::string(name);};
 
 // C++ random number generator
 inline std::default_random_engine rng = std::default_random_engine(std::random_device()());;
 inline std::uniform_real_distribution<float> uniform_dist; // number between 0..1
+// Seeds rng and rand() alike, input recordings store the seed to reproduce a run
+inline void seed_random(unsigned int seed) {
+	rng.seed(seed);
+	uniform_dist.reset();
+	srand(seed);
+}
 
 //
 // game constants
@@ -96,6 +104,23 @@ const vec3 TIMER_TEXT_FLASH_COLOR = { 1.0f, 0.25f, 0.25f };
 const int BOX_MARGIN = 20;
 
 const float FPS_TEXT_UPDATE_MS = 300.f;
+const int PERF_OVERLAY_LINE_COUNT = 5;
+
+// Fixed simulation rate, can be lowered on weak machines without changing the game speed
+const float SIMULATION_TICK_HZ = 60.f;
+const float SIMULATION_TICK_MS = 1000.f / SIMULATION_TICK_HZ;
+// Most ticks run to catch up after a slow frame, any further backlog is dropped
+const int MAX_SIMULATION_TICKS_PER_FRAME = 5;
+
+// Let vsync pace the frames by default, as the game always did. --no-vsync hands them to the frame pacer for a run
+const bool ENABLE_VSYNC = true;
+// How often the achieved frame times and jitter are logged, 0 to never log them
+const float FRAME_JITTER_REPORT_MS = 10000.f;
+
+// Profiler, F8 toggles recording and F9 writes the last PROFILER_TRACE_FRAMES frames to PROFILER_TRACE_FILE in the build directory
+const bool PROFILER_RECORD_AT_START = false;
+const unsigned int PROFILER_TRACE_FRAMES = 300;
+const std::string PROFILER_TRACE_FILE = "frame_trace.json";
 
 // Utility functions to convert positions <-> grid cells
 // Returns the grid coordinates that the given screen position falls into
@@ -1,27 +1,37 @@
 #include "fire_system.hpp"
+#include "utils/profiler.hpp"
 
+// Fire can spread into empty cells and cells holding only an ingredient or powerup
+static bool isSpreadable(std::pair<int, int> cell) {
+    return !registry.grid.any(cell, ~(grid_layer_bit(GRID_LAYER::INGREDIENT) | grid_layer_bit(GRID_LAYER::POWERUP)));
+}
 
+// Structural changes are deferred to the registry's command buffer, since this is called while
+// fireBlocks (FireSystem::step) or enemies (AISystem::step) are being iterated
 bool FireSystem::handleFireBlockChainInteraction(vec2 position, Direction direction, bool player_induced, bool enemy_induced) {
     vec2 progressed_position = progress_direction(position, direction);
-    std::optional<Entity> progressed_entity = registry.map_grid_coord_entityID[position_to_grid_coords(progressed_position)];
+    std::pair<int, int> progressed_cell = position_to_grid_coords(progressed_position);
+    std::optional<Entity> progressed_fire = registry.grid.get(progressed_cell, GRID_LAYER::FIRE);
 
-    if (!progressed_entity.has_value() ||
-        (progressed_entity.has_value() &&
-        (registry.ingredients.has(progressed_entity.value()) || registry.powerups.has(progressed_entity.value())))) {
-            createFireBlock(progressed_position, direction);
+    if (isSpreadable(progressed_cell)) {
+			registry.defer([progressed_position, direction]() {
+				// Another fire may have claimed the cell before the flush
+				if (isSpreadable(position_to_grid_coords(progressed_position))) {
+					createFireBlock(progressed_position, direction);
+				}
+			});
 			return true;
-    } else if (progressed_entity.has_value() && registry.fireBlocks.has(progressed_entity.value())) {
+    } else if (progressed_fire.has_value()) {
         if (player_induced) {
-			FireBlock& fire = registry.fireBlocks.get(progressed_entity.value());
+			FireBlock& fire = registry.fireBlocks.get(progressed_fire.value());
 
 			fire.to_delete = true;
 			fire.has_spawned_next = true;
 			fire.direction = direction;
 			fire.timer = 0.0f;
 		} else if (enemy_induced) {
-			Entity fire_entity = progressed_entity.value();
-			createSmoke(progressed_position);
-            registry.remove_all_components_of(fire_entity);
+			registry.defer([progressed_position]() { createSmoke(progressed_position); });
+            registry.defer_destroy(progressed_fire.value());
 		}
 		return true;
     }
@@ -29,6 +39,7 @@ bool FireSystem::handleFireBlockChainInteraction(vec2 position, Direction direct
 }
 
 void FireSystem::step(float elapsed_ms) {
+	PROFILE_SYSTEM_SCOPE("FireSystem::step", PERF_SYSTEM::FIRE);
     // Player fire interaction queue handling
     for (Entity e : registry.players.entities) {
 		Player& player = registry.players.get(e);
@@ -48,12 +59,7 @@ void FireSystem::step(float elapsed_ms) {
     }
 
     // Fire handling
-    for (Entity e : registry.fireBlocks.entities) {
-		// Protect against cases where creating fires in quick succession
-		// results in temporarily uninitialized Entities
-		if (!registry.fireBlocks.has(e) || !registry.motions.has(e)) continue;
-        FireBlock& fire = registry.fireBlocks.get(e);
-        Motion& fire_motion = registry.motions.get(e);
+    for (auto [e, fire, fire_motion] : registry.view<FireBlock, Motion>()) {
 
 		// Update fire light flickering
 		if (fire.light_timer < FireBlock::transition_time) {
@@ -87,9 +93,9 @@ void FireSystem::step(float elapsed_ms) {
 					handleFireBlockChainInteraction(fire_motion.position, fire.direction, false, false);
 				} else if (fire.to_delete) {
                     vec2 progressed_position = progress_direction(fire_motion.position, fire.direction);
-                    std::optional<Entity> progressed_entity = registry.map_grid_coord_entityID[position_to_grid_coords(progressed_position)];
-					if (progressed_entity.has_value() && registry.fireBlocks.has(progressed_entity.value())) {
-						FireBlock& next_fire = registry.fireBlocks.get(progressed_entity.value());
+                    std::optional<Entity> progressed_fire = registry.grid.get(position_to_grid_coords(progressed_position), GRID_LAYER::FIRE);
+					if (progressed_fire.has_value()) {
+						FireBlock& next_fire = registry.fireBlocks.get(progressed_fire.value());
 						next_fire.to_delete = true;
 						next_fire.has_spawned_next = true;
 						next_fire.direction = fire.direction;
@@ -97,8 +103,8 @@ void FireSystem::step(float elapsed_ms) {
 					}
 
 					// Create smoke block and particle spawner right before destroying fire
-					createSmoke(fire_motion.position);
-					registry.remove_all_components_of(e);
+					registry.defer([position = fire_motion.position]() { createSmoke(position); });
+					registry.defer_destroy(e);
 				}
 			} else {
 				fire.timer -= elapsed_ms;
@@ -1,4 +1,5 @@
 #include "fonts.hpp"
+#include "../utils/profiler.hpp"
 
 #include <iostream>
 
@@ -134,6 +135,7 @@ void Font::renderLine(TextLine& line, float scale) {
 		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
 		
 		// render quad
+		perf_stats.count(PERF_COUNTER::DRAW_CALLS);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 		
 		// now advance cursors for next glyph (note that advance is number of 1/64 pixels)
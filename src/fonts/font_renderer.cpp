@@ -12,6 +12,8 @@ FontRenderer::~FontRenderer() {
 
 void FontRenderer::init(GLuint _shader) {
 	shader = _shader;
+	text_color_uloc = glGetUniformLocation(shader, "textColor");
+	projection_uloc = glGetUniformLocation(shader, "projection");
 	
 	// Load fonts
 	for (int i = 0; i < FONT_ASSET_ID::FONT_COUNT; i++) {
@@ -29,7 +31,7 @@ void FontRenderer::render(TextRenderRequest& request) {
 	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &prev_vao);
 	
 	glUseProgram(shader);
-	glUniform3f(glGetUniformLocation(shader, "textColor"), request.color.x, request.color.y, request.color.z);
+	glUniform3f(text_color_uloc, request.color.x, request.color.y, request.color.z);
 	
 	// Load font
 	Font& font = fonts[request.font];
@@ -47,5 +49,5 @@ mat4 FontRenderer::createProjectionMatrix(float width, float height) {
 void FontRenderer::use(int width, int height) {
 	mat4 projection = createProjectionMatrix(width, height);
 	glUseProgram(shader);
-	glUniformMatrix4fv(glGetUniformLocation(shader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+	glUniformMatrix4fv(projection_uloc, 1, GL_FALSE, glm::value_ptr(projection));
 }
\ No newline at end of file
@@ -63,6 +63,8 @@ namespace GameText {
             mat4 createProjectionMatrix(float width, float height);
             
             GLuint shader;
+            GLint text_color_uloc = -1;
+            GLint projection_uloc = -1;
             std::map<FONT_ASSET_ID, Font> fonts;
 
     public:
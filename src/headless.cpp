@@ -0,0 +1,162 @@
+#include "headless.hpp"
+
+// stdlib
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+// internal
+#include "ai_system.hpp"
+#include "fire_system.hpp"
+#include "map_generator.hpp"
+#include "mesh_library.hpp"
+#include "particle_system.hpp"
+#include "physics_system.hpp"
+#include "popup_window.hpp"
+#include "world_init.hpp"
+#include "world_system.hpp"
+#include "utils/error_log.hpp"
+#include "utils/profiler.hpp"
+
+namespace {
+	struct ScriptedKey {
+		int tick;
+		int key;
+		int action;
+	};
+
+	int parseKeyName(const std::string& name) {
+		if (name == "SPACE") return GLFW_KEY_SPACE;
+		if (name == "ENTER") return GLFW_KEY_ENTER;
+		if (name == "ESCAPE") return GLFW_KEY_ESCAPE;
+		// GLFW letter and digit keys match their upper case ASCII codes
+		if (name.size() == 1 && std::isalnum((unsigned char)name[0])) return std::toupper((unsigned char)name[0]);
+		return GLFW_KEY_UNKNOWN;
+	}
+
+	bool loadInputScript(const std::string& path, std::vector<ScriptedKey>& script) {
+		std::ifstream file(path);
+		if (!file.is_open()) {
+			ERROR_LOG << "Could not open input script " << path;
+			return false;
+		}
+		std::string line;
+		int line_number = 0;
+		while (std::getline(file, line)) {
+			line_number++;
+			if (line.empty() || line[0] == '#') continue;
+
+			std::istringstream fields(line);
+			ScriptedKey event;
+			std::string key, action;
+			if (!(fields >> event.tick >> key >> action) || (event.key = parseKeyName(key)) == GLFW_KEY_UNKNOWN ||
+				(action != "press" && action != "release")) {
+				ERROR_LOG << "Malformed line " << line_number << " in input script " << path << ": " << line;
+				return false;
+			}
+			event.action = action == "press" ? GLFW_PRESS : GLFW_RELEASE;
+			script.push_back(event);
+		}
+		std::stable_sort(script.begin(), script.end(), [](const ScriptedKey& a, const ScriptedKey& b) { return a.tick < b.tick; });
+		return true;
+	}
+}
+
+bool parseHeadlessArgs(int argc, char* argv[], HeadlessOptions& options) {
+	bool headless = false;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--headless") {
+			headless = true;
+		} else if (arg == "--level" && i + 1 < argc) {
+			options.level = std::atoi(argv[++i]);
+		} else if (arg == "--ticks" && i + 1 < argc) {
+			options.max_ticks = std::atoi(argv[++i]);
+		} else if (arg == "--input" && i + 1 < argc) {
+			options.input_script = argv[++i];
+		} else if (arg == "--trace" && i + 1 < argc) {
+			options.trace_file = argv[++i];
+		}
+	}
+	return headless;
+}
+
+int runHeadless(const HeadlessOptions& options) {
+	if (options.level < 1 || options.level > REAL_LEVEL_COUNT) {
+		ERROR_LOG << "Invalid level " << options.level << ", expected 1 to " << REAL_LEVEL_COUNT;
+		return EXIT_FAILURE;
+	}
+	std::vector<ScriptedKey> script;
+	if (!options.input_script.empty() && !loadInputScript(options.input_script, script)) {
+		return EXIT_FAILURE;
+	}
+
+	AISystem	  		ai_system;
+	WorldSystem   		world_system;
+	MeshLibrary   		meshes;
+	PhysicsSystem 		physics_system;
+	FireSystem 			fire_system;
+	ParticleSystem 		particle_system;
+	MapGenerator 		map_generator;
+	PopupWindow     	popup_window;
+
+	// No window, gl context or audio device is ever created, and there is no renderer. The meshes are only
+	// loaded for the mesh colliders.
+	meshes.load();
+	map_generator.init(nullptr);
+	physics_system.init(&meshes);
+	world_system.init(&map_generator, popup_window);
+	particle_system.init();
+	createPlayer();
+
+	// Straight into the level, skipping the level select screen and the level start popup
+	GameState& game_state = world_system.get_game_state();
+	LEVEL_ASSET_ID level_id = (LEVEL_ASSET_ID)((int)LEVEL_ASSET_ID::LEVEL_1 + options.level - 1);
+	game_state.cur_level = options.level;
+	game_state.cur_screen = GAME_SCREEN::PLAYING;
+	game_state.show_popup = false;
+	map_generator.load(level_id);
+	registry.flush_commands();
+
+	profiler.set_recording(!options.trace_file.empty());
+
+	auto start = std::chrono::steady_clock::now();
+	size_t next_key = 0;
+	int tick = 0;
+	for (; tick < options.max_ticks; tick++) {
+		// The level is over once a popup (win, death or timeout) shows up
+		if (game_state.cur_screen != GAME_SCREEN::PLAYING || game_state.show_popup) break;
+
+		profiler.begin_frame();
+		PROFILE_SCOPE("Simulation tick");
+
+		for (; next_key < script.size() && script[next_key].tick <= tick; next_key++) {
+			world_system.inject_key(script[next_key].key, script[next_key].action);
+		}
+
+		world_system.handle_collisions();
+		world_system.step(SIMULATION_TICK_MS);
+		fire_system.step(SIMULATION_TICK_MS);
+		physics_system.step(SIMULATION_TICK_MS);
+		ai_system.step(SIMULATION_TICK_MS);
+		particle_system.step(SIMULATION_TICK_MS);
+		registry.flush_commands();
+	}
+	float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+	static const char* status_names[] = { "IDLE", "ALIVE", "WIN", "LOSE", "TIMEOUT" };
+	std::cout << "Level " << options.level << ": " << tick << " ticks (" << tick * SIMULATION_TICK_MS / 1000.f
+			  << " s of game time) in " << seconds << " s, " << (seconds > 0.f ? tick / seconds : 0.f)
+			  << " ticks/s, status " << status_names[(int)game_state.status] << std::endl;
+
+	if (!options.trace_file.empty() && !profiler.write_chrome_trace(options.trace_file, (uint32_t)tick)) {
+		ERROR_LOG << "Could not write profiler trace to " << options.trace_file;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
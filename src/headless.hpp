@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+// Options of a headless run, see parseHeadlessArgs
+struct HeadlessOptions {
+	int level = 1;				// 1 to REAL_LEVEL_COUNT
+	int max_ticks = 60 * 60;	// stops earlier if the level ends
+	std::string input_script;	// optional, see runHeadless
+	std::string trace_file;		// optional, records the run and writes it as a Chrome trace
+};
+
+// Parses "--headless [--level N] [--ticks N] [--input FILE] [--trace FILE]", returns false if argv does not ask for a headless run
+bool parseHeadlessArgs(int argc, char* argv[], HeadlessOptions& options);
+
+// Loads a level and runs the gameplay systems on fixed ticks as fast as possible, without a window, OpenGL or audio.
+// Prints the simulated ticks per second when done.
+// The input script has one key event per line, "<tick> <key> <press|release>", where key is a letter or
+// SPACE, ENTER or ESCAPE. Lines starting with # are ignored.
+int runHeadless(const HeadlessOptions& options);
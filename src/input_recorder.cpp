@@ -0,0 +1,114 @@
+#include "input_recorder.hpp"
+#include "world_system.hpp"
+#include "utils/error_log.hpp"
+
+#include <cstring>
+#include <random>
+
+bool InputRecorder::start_recording(const std::string& path) {
+	out.open(path, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) {
+		ERROR_LOG << "Could not create input recording " << path;
+		return false;
+	}
+	seed = std::random_device()();
+	seed_random(seed);
+	current_mode = MODE::RECORDING;
+	return true;
+}
+
+bool InputRecorder::start_replay(const std::string& path) {
+	in.open(path, std::ios::binary);
+	if (!in.is_open()) {
+		ERROR_LOG << "Could not open input recording " << path;
+		return false;
+	}
+	char magic[sizeof(MAGIC)];
+	uint32_t version = 0;
+	if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || !read(version) || version != VERSION ||
+		!read(seed) || !read(unlocked_levels)) {
+		ERROR_LOG << path << " is not an input recording of this version";
+		in.close();
+		return false;
+	}
+	seed_random(seed);
+	current_mode = MODE::REPLAYING;
+	return true;
+}
+
+bool InputRecorder::begin_frame(float& elapsed_ms, WorldSystem& world) {
+	if (current_mode == MODE::RECORDING) {
+		if (frames == 0) {
+			out.write(MAGIC, sizeof(MAGIC));
+			write(VERSION);
+			write(seed);
+			write(unlocked_levels);
+		}
+		write(RECORD_TYPE::FRAME);
+		write(elapsed_ms);
+		frames++;
+		return true;
+	}
+	if (current_mode != MODE::REPLAYING) {
+		return true;
+	}
+
+	RECORD_TYPE type;
+	if (!read(type) || type != RECORD_TYPE::FRAME || !read(elapsed_ms)) {
+		return false;
+	}
+	frames++;
+
+	// Feed every input record up to the next frame
+	while (in.peek() != std::char_traits<char>::eof() && in.peek() != (int)RECORD_TYPE::FRAME) {
+		read(type);
+		switch (type) {
+			case RECORD_TYPE::KEY: {
+				int16_t key;
+				uint8_t action, mod;
+				if (read(key) && read(action) && read(mod))
+					world.inject_key(key, action, mod);
+				break;
+			}
+			case RECORD_TYPE::MOUSE_MOVE: {
+				vec2 position;
+				if (read(position.x) && read(position.y))
+					world.inject_mouse_move(position);
+				break;
+			}
+			case RECORD_TYPE::MOUSE_BUTTON: {
+				uint8_t button, action, mods;
+				if (read(button) && read(action) && read(mods))
+					world.inject_mouse_button(button, action, mods);
+				break;
+			}
+			default:
+				ERROR_LOG << "Corrupt input recording at frame " << frames;
+				return false;
+		}
+	}
+	return true;
+}
+
+void InputRecorder::record_key(int key, int action, int mod) {
+	if (current_mode != MODE::RECORDING) return;
+	write(RECORD_TYPE::KEY);
+	write((int16_t)key);
+	write((uint8_t)action);
+	write((uint8_t)mod);
+}
+
+void InputRecorder::record_mouse_move(vec2 position) {
+	if (current_mode != MODE::RECORDING) return;
+	write(RECORD_TYPE::MOUSE_MOVE);
+	write(position.x);
+	write(position.y);
+}
+
+void InputRecorder::record_mouse_button(int button, int action, int mods) {
+	if (current_mode != MODE::RECORDING) return;
+	write(RECORD_TYPE::MOUSE_BUTTON);
+	write((uint8_t)button);
+	write((uint8_t)action);
+	write((uint8_t)mods);
+}
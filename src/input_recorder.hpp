@@ -0,0 +1,69 @@
+#pragma once
+
+#include <fstream>
+#include <stdint.h>
+#include <string>
+
+#include "common.hpp"
+
+class WorldSystem;
+
+// Records a play session (random seed, the elapsed time of every frame and every input event) to a binary file,
+// and replays such a file by feeding back the same frame times and input. With the same seed, frame times and
+// input the fixed-timestep simulation runs the exact same ticks, so a recording doubles as a repeatable benchmark.
+//
+// File layout, little endian: header { "BCPR", uint32 version, uint32 seed, uint32 unlocked levels }, then a stream of records each starting
+// with a uint8 RECORD_TYPE. A FRAME record holds the frame's elapsed ms, the input records after it belong to that frame.
+class InputRecorder
+{
+public:
+	enum class MODE { OFF, RECORDING, REPLAYING };
+
+	// Creates the file and seeds the random sources with a fresh seed that is stored in it. The header is written
+	// with the first frame, after the world has loaded the save and passed its unlocks to set_unlocked_levels.
+	bool start_recording(const std::string& path);
+	// Opens a recording and seeds the random sources with its seed, call before any system uses them
+	bool start_replay(const std::string& path);
+
+	MODE mode() const { return current_mode; }
+	bool replaying() const { return current_mode == MODE::REPLAYING; }
+
+	// Level unlocks as a bit per level, level 1 in bit 0. A recording stores the ones of the save it was started
+	// with, so that a replay does not depend on the local save.
+	void set_unlocked_levels(uint32_t levels) { unlocked_levels = levels; }
+	uint32_t recorded_unlocked_levels() const { return unlocked_levels; }
+
+	// Call at the start of every frame, before input is polled.
+	// Recording stores elapsed_ms. A replay overwrites elapsed_ms with the recorded value and feeds the frame's input
+	// to world, it returns false once the recording is exhausted.
+	bool begin_frame(float& elapsed_ms, WorldSystem& world);
+
+	// Input from the window, stored while recording
+	void record_key(int key, int action, int mod);
+	void record_mouse_move(vec2 position);
+	void record_mouse_button(int button, int action, int mods);
+
+	// Frames recorded or replayed so far
+	uint32_t frame_count() const { return frames; }
+
+private:
+	enum class RECORD_TYPE : uint8_t {
+		FRAME = 0,
+		KEY,
+		MOUSE_MOVE,
+		MOUSE_BUTTON
+	};
+
+	static constexpr char MAGIC[4] = { 'B', 'C', 'P', 'R' };
+	static constexpr uint32_t VERSION = 2;
+
+	MODE current_mode = MODE::OFF;
+	std::ofstream out;
+	std::ifstream in;
+	uint32_t frames = 0;
+	uint32_t seed = 0;
+	uint32_t unlocked_levels = 0;
+
+	template <typename T> void write(const T& value) { out.write((const char*)&value, sizeof(T)); }
+	template <typename T> bool read(T& value) { return (bool)in.read((char*)&value, sizeof(T)); }
+};
@@ -3,6 +3,7 @@
 #include <gl3w.h>
 
 // stdlib
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 
@@ -19,12 +20,27 @@
 
 #include "map_generator.hpp"
 #include "popup_window.hpp"
+#include "headless.hpp"
+#include "input_recorder.hpp"
 
-using Clock = std::chrono::high_resolution_clock;
+#include "utils/debug_log.hpp"
+#include "utils/frame_pacer.hpp"
+#include "utils/profiler.hpp"
 
 // Entry point
-int main()
+int main(int argc, char* argv[])
 {
+	// --headless runs a level without window, rendering or audio, e.g. for profiling the simulation
+	HeadlessOptions headless_options;
+	if (parseHeadlessArgs(argc, argv, headless_options)) {
+		return runHeadless(headless_options);
+	}
+#ifdef HEADLESS_ONLY
+	// Built without GLFW, OpenGL and SDL, see HEADLESS_ONLY in CMakeLists.txt
+	std::cerr << "ERROR: This build can only run --headless" << std::endl;
+	return EXIT_FAILURE;
+#else
+
 	// global systems
 	AISystem	  		ai_system;
 	WorldSystem   		world_system;
@@ -36,6 +52,26 @@ int main()
 	TutorialSystem 		tutorial_system;
     PopupWindow     	popup_window;
 
+	// --vsync and --no-vsync choose between vsync and the frame pacer for this run
+	bool vsync = ENABLE_VSYNC;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--vsync" || arg == "--no-vsync")
+			vsync = arg == "--vsync";
+	}
+
+	// --record FILE saves the session's seed, frame times and input, --replay FILE plays such a session back
+	// unthrottled as a benchmark. Either has to start before any system draws random numbers.
+	InputRecorder input_recorder;
+	for (int i = 1; i + 1 < argc; i++) {
+		std::string arg = argv[i];
+		if ((arg == "--record" && !input_recorder.start_recording(argv[i + 1])) ||
+			(arg == "--replay" && !input_recorder.start_replay(argv[i + 1]))) {
+			return EXIT_FAILURE;
+		}
+	}
+	world_system.set_input_recorder(&input_recorder);
+
 	// initialize window
 	GLFWwindow* window = world_system.create_window();
 	if (!window) {
@@ -52,7 +88,7 @@ int main()
 	// initialize the main systems
 	map_generator.init(&renderer_system);
 	renderer_system.init(window);
-	physics_system.init(&renderer_system);
+	physics_system.init(&renderer_system.getMeshes());
 	world_system.init(&map_generator, popup_window);
 	tutorial_system.init(&map_generator, popup_window);
 	particle_system.init();
@@ -64,30 +100,40 @@ int main()
 	GameState& game_state = world_system.get_game_state();
 
 	const int FPS = 120;
-	const float FRAME_DURATION_MS = std::round((1000.f / FPS) * 100) / 100;
-	
-	// variable timestep loop
-	auto t = Clock::now();
-	while (!world_system.is_over()) {
+	const float FRAME_DURATION_MS = 1000.f / FPS;
 
-		// calculate elapsed times in milliseconds from the previous iteration
-		auto now = Clock::now();
-		float elapsed_ms =
-		(float)(std::chrono::duration_cast<std::chrono::microseconds>(now - t)).count() / 1000;
-		
-		// 16.66ms has not passed yet so keep busy-waiting
-		if (elapsed_ms < FRAME_DURATION_MS) continue;
+	// With vsync the buffer swap blocks until the display is ready, so the pacer only measures
+	glfwSwapInterval(vsync ? 1 : 0);
+	FramePacer frame_pacer;
+	frame_pacer.init(vsync || input_recorder.replaying() ? 0.f : FRAME_DURATION_MS);
+	auto run_start = std::chrono::steady_clock::now();
+
+	// Fixed timestep: the simulation advances in ticks of SIMULATION_TICK_MS whatever the frame time,
+	// the renderer interpolates motions between the last two ticks
+	float tick_accumulator_ms = 0.f;
+
+	profiler.set_recording(PROFILER_RECORD_AT_START);
 
-		// NOTE: using FRAME_DURATION_MS might be too accurate so the frame text will not update
-		// Give it some leeway instead of 16.6666667, use 16.66 for 60fps, so it shows that it is actually
-		// updating
+	while (!world_system.is_over()) {
+
+		// sleep until the next frame is due, and get the elapsed time in milliseconds from the previous iteration
+		float elapsed_ms = frame_pacer.wait_for_next_frame();
 
-		// This ensures that elapsed time is approx. 16.66 ms which is 60fps
-		// if (elapsed_ms < 16.66f) continue;
+		profiler.begin_frame();
+		PROFILE_SCOPE("Frame");
 
-		// Update time
-		t = now;
+		if (FRAME_JITTER_REPORT_MS > 0.f && frame_pacer.report_window_ms() >= FRAME_JITTER_REPORT_MS) {
+			FramePacer::Report report = frame_pacer.take_report();
+			DEBUG_LOG << "Frame time over " << report.frames << " frames: mean " << report.mean_ms
+					  << " ms, jitter " << report.jitter_ms << " ms, worst " << report.worst_ms << " ms";
+		}
 		
+		// A replay swaps in the recorded frame time and feeds the recorded input, live input is ignored
+		float real_elapsed_ms = elapsed_ms;
+		if (!input_recorder.begin_frame(elapsed_ms, world_system)) {
+			break;
+		}
+
 		// processes system messages, if this wasn't present the window would become unresponsive
 		glfwPollEvents();
 
@@ -95,37 +141,66 @@ int main()
             tutorial_system.reset();
         }
 
-		// Check which screen user is currently on
-		switch(game_state.cur_screen) {
-			case GAME_SCREEN::TUTORIAL_PLAYING:
-				// adds tutorial_system to regular game play
-				if (!game_state.show_popup) {
-					tutorial_system.step(elapsed_ms);
-                }
-			
-			case GAME_SCREEN::PLAYING:
-                if (!game_state.show_popup) {
-                    world_system.handle_collisions();
-                
-                    world_system.step(elapsed_ms);
-                    fire_system.step(elapsed_ms);
-                    physics_system.step(elapsed_ms);
-                    ai_system.step(elapsed_ms);
-                    particle_system.step(elapsed_ms);
-                }
-				break;
-			case GAME_SCREEN::STORY:
-			case GAME_SCREEN::TUTORIAL:
-			case GAME_SCREEN::GAME_SCREEN_COUNT:
-			case GAME_SCREEN::START:
-			case GAME_SCREEN::SETTINGS:
-			case GAME_SCREEN::LEVEL_SELECT:
-			case GAME_SCREEN::END:
-				break;
+		tick_accumulator_ms = std::min(tick_accumulator_ms + elapsed_ms, MAX_SIMULATION_TICKS_PER_FRAME * SIMULATION_TICK_MS);
+		while (tick_accumulator_ms >= SIMULATION_TICK_MS) {
+			PROFILE_SCOPE("Simulation tick");
+			tick_accumulator_ms -= SIMULATION_TICK_MS;
+			renderer_system.snapshotMotions();
+
+			// Check which screen user is currently on
+			switch(game_state.cur_screen) {
+				case GAME_SCREEN::TUTORIAL_PLAYING:
+					// adds tutorial_system to regular game play
+					if (!game_state.show_popup) {
+						tutorial_system.step(SIMULATION_TICK_MS);
+					}
+				
+				case GAME_SCREEN::PLAYING:
+					if (!game_state.show_popup) {
+						world_system.handle_collisions();
+					
+						world_system.step(SIMULATION_TICK_MS);
+						fire_system.step(SIMULATION_TICK_MS);
+						physics_system.step(SIMULATION_TICK_MS);
+						ai_system.step(SIMULATION_TICK_MS);
+						particle_system.step(SIMULATION_TICK_MS);
+					}
+					break;
+				case GAME_SCREEN::STORY:
+				case GAME_SCREEN::TUTORIAL:
+				case GAME_SCREEN::GAME_SCREEN_COUNT:
+				case GAME_SCREEN::START:
+				case GAME_SCREEN::SETTINGS:
+				case GAME_SCREEN::LEVEL_SELECT:
+				case GAME_SCREEN::END:
+					break;
+			}
+
+			// Sync point: apply the creates/destroys the systems deferred this tick
+			PROFILE_SCOPE("ECSRegistry::flush_commands");
+			registry.flush_commands();
 		}
 
-		renderer_system.draw(game_state.cur_screen);
+		if (game_state.cur_screen == GAME_SCREEN::PLAYING || game_state.cur_screen == GAME_SCREEN::TUTORIAL_PLAYING) {
+			world_system.update_fps_text(elapsed_ms);
+		}
+
+		// Apply anything deferred outside the simulation, e.g. by input callbacks
+		registry.flush_commands();
+
+		renderer_system.draw(game_state.cur_screen, tick_accumulator_ms / SIMULATION_TICK_MS);
+
+		perf_stats.end_frame(real_elapsed_ms);
+	}
+
+	if (input_recorder.replaying()) {
+		float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - run_start).count();
+		std::cout << "Replayed " << input_recorder.frame_count() << " frames in " << seconds << " s, mean frame "
+				  << seconds * 1000.f / std::max(input_recorder.frame_count(), 1u) << " ms, last 256 frames p50 "
+				  << perf_stats.frame_percentile(50.f) << " p95 " << perf_stats.frame_percentile(95.f)
+				  << " p99 " << perf_stats.frame_percentile(99.f) << std::endl;
 	}
 
 	return EXIT_SUCCESS;
+#endif
 }
@@ -38,36 +38,35 @@ void MapGenerator::clearMap() {
 		return;
 	}
 
+	// Changes recorded against the old level must not leak into the next one
+	registry.discard_commands();
+
 	for (Entity entity : level_entities) {
-		registry.remove_all_components_of(entity);
+		registry.destroy_entity(entity);
 	}
 	
 	level_entities.clear();
 
-    // Also remove all fire blocks and smoke particles
-    for (Entity e : registry.fireBlocks.entities) {
-        registry.remove_all_components_of(e);
-    }
+    // Also remove all fire blocks and smoke particles.
+    // Destroying shrinks the container, so always take the last entity instead of iterating it
+    while (registry.fireBlocks.entities.size() > 0)
+        registry.destroy_entity(registry.fireBlocks.entities.back());
 
-    for (Entity e : registry.smokeBlocks.entities) {
-        registry.remove_all_components_of(e);
-    }
+    while (registry.smokeBlocks.entities.size() > 0)
+        registry.destroy_entity(registry.smokeBlocks.entities.back());
 
     // remove smoke at restart
-    for (Entity p : registry.particleSpawners.entities) {
-        registry.remove_all_components_of(p);
-    }
+    while (registry.particleSpawners.entities.size() > 0)
+        registry.destroy_entity(registry.particleSpawners.entities.back());
 
-    for (Entity p : registry.particles.entities) {
-        registry.remove_all_components_of(p);
-    }
+    while (registry.particles.entities.size() > 0)
+        registry.destroy_entity(registry.particles.entities.back());
 
     // Remove map entity
-    for (Entity e : registry.maps.entities) {
-        registry.remove_all_components_of(e);
-    }
+    while (registry.maps.entities.size() > 0)
+        registry.destroy_entity(registry.maps.entities.back());
 
-    registry.clear_grid_entity_map();
+    registry.grid.clear();
 
     // Clear settings entities
     registry.remove_all_components_of(settings_btn_outer);
@@ -249,8 +248,9 @@ void MapGenerator::load(LEVEL_ASSET_ID lid) {
     }
     file.close();
 
-    // Clear the current map and set the active level
-    clearMap();
+    // Clear the current map, if one was loaded, and set the active level
+    if (active_level != LEVEL_ASSET_ID::LEVEL_COUNT)
+        clearMap();
     active_level = lid;
 
     // Retrieve map dimensions and floor texture from JSON
@@ -292,6 +292,7 @@ void MapGenerator::load(LEVEL_ASSET_ID lid) {
     map.num_rows = num_rows;
     map.hasLimitedVision = hasLimitedVision;
     map.shadowColor = shadowColor;
+    registry.grid.resize(num_rows, num_cols);
 
     // Create the floor using the provided floorAssetId (if your createFloor uses it)
     level_entities.push_back(createFloor(floorAssetId, num_cols, num_cols));
@@ -389,8 +390,8 @@ void MapGenerator::resetPlayer(vec2 position) {
     player.start_pos = position;
     player.end_pos = position;
     player.transition_factor = 0.0f;
-	registry.remove_from_grid_entity_map(player_entity);
-	registry.map_grid_coord_entityID[position_to_grid_coords(position)] = player_entity;
+	registry.grid.remove(player_entity);
+	registry.grid.set(position_to_grid_coords(position), GRID_LAYER::PLAYER, player_entity);
 }
 
 Entity MapGenerator::createFloor(int asset_idx, int num_rows, int num_cols) {
@@ -405,6 +406,7 @@ Entity MapGenerator::createFloor(int asset_idx, int num_rows, int num_cols) {
 
     // Add floor component
     registry.floors.emplace(entity);
+    registry.staticBodies.emplace(entity);
 
     // Add a motion component;
     Motion& motion = registry.motions.emplace(entity);
@@ -0,0 +1,11 @@
+#include "mesh_library.hpp"
+
+void MeshLibrary::load()
+{
+	for (const std::pair<GEOMETRY_BUFFER_ID, std::string>& mesh_path : mesh_paths)
+	{
+		Mesh& mesh = get(mesh_path.first);
+		Mesh::loadFromOBJFile(mesh_path.second, mesh.vertices, mesh.vertex_indices, mesh.original_size);
+		mesh.buildCollisionBVH();
+	}
+}
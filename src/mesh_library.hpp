@@ -0,0 +1,28 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "tinyECS/components.hpp"
+
+// The meshes loaded from data/meshes, with the bounding volumes mesh colliders are tested against.
+// Only reads files, the renderer uploads the vertices to its own gl buffers, so headless runs can load meshes
+// without a gl context.
+class MeshLibrary
+{
+	std::array<Mesh, geometry_count> meshes;
+
+public:
+	// necessary for render function initializeglmeshes but idk what to do with chicken
+	const std::vector<std::pair<GEOMETRY_BUFFER_ID, std::string>> mesh_paths = {
+		std::pair<GEOMETRY_BUFFER_ID, std::string>(GEOMETRY_BUFFER_ID::STAR, mesh_path("star.obj"))
+	};
+
+	// Loads every mesh in mesh_paths and builds its collision BVH
+	void load();
+
+	Mesh& get(GEOMETRY_BUFFER_ID id) { return meshes[(int)id]; }
+};
@@ -1,6 +1,8 @@
 #include "particle_system.hpp"
 #include <algorithm>
 
+#include "utils/profiler.hpp"
+
 void ParticleSystem::init() {
     // Create a particle spawner
     InstanceRequest& ir = registry.instanceRequests.emplace(particle_instance_entity);
@@ -51,7 +53,7 @@ void ParticleSystem::updateParticle(float elapsed_ms, Entity& particle_entity, s
     // Decrease lifespan
     particle.lifespan -= elapsed_ms * 0.001f;
     if (particle.lifespan <= 0.0f) {
-        registry.remove_all_components_of(particle_entity);
+        registry.defer_destroy(particle_entity);
         return;
     }
 
@@ -74,6 +76,7 @@ void ParticleSystem::updateParticle(float elapsed_ms, Entity& particle_entity, s
 }
 
 void ParticleSystem::step(float elapsed_ms) {
+	PROFILE_SYSTEM_SCOPE("ParticleSystem::step", PERF_SYSTEM::PARTICLES);
     auto& particleSpawners = registry.particleSpawners.components;
     auto& particle_entities = registry.particles.entities;
 
@@ -82,7 +85,7 @@ void ParticleSystem::step(float elapsed_ms) {
         SmokeBlock& smoke_block = registry.smokeBlocks.get(e);
 
         if (smoke_block.lifespan < 0.f) {
-            registry.remove_all_components_of(e);
+            registry.defer_destroy(e);
         } else {
             smoke_block.lifespan -= elapsed_ms;
         }
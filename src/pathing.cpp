@@ -0,0 +1,284 @@
+#include "pathing.hpp"
+#include "tinyECS/registry.hpp"
+
+#include <algorithm>
+
+#include "utils/profiler.hpp"
+
+void PathSearch::resize(int rows, int cols) {
+	num_rows = rows;
+	num_cols = cols;
+	size_t size = (size_t)rows * cols;
+	seen.assign(size, 0);
+	closed.assign(size, 0);
+	cost.assign(size, 0);
+	parent.assign(size, -1);
+	generation = 0;
+}
+
+bool PathSearch::findPath(ivec2 start, ivec2 goal, bool (*isCellOccupied)(ivec2 position), std::vector<ivec2>& path) {
+	PROFILE_SCOPE("PathSearch::findPath");
+	path.clear();
+
+	if (registry.grid.rows() != num_rows || registry.grid.cols() != num_cols) {
+		resize(registry.grid.rows(), registry.grid.cols());
+	}
+	auto in_bounds = [this](ivec2 p) { return p.x >= 0 && p.y >= 0 && p.x < num_cols && p.y < num_rows; };
+	if (!in_bounds(start) || !in_bounds(goal)) {
+		return false;
+	}
+
+	// A new generation invalidates all state of the previous search, only wrap-around needs a real clear
+	if (++generation == 0) {
+		std::fill(seen.begin(), seen.end(), 0);
+		std::fill(closed.begin(), closed.end(), 0);
+		generation = 1;
+	}
+
+	auto heuristic = [goal](ivec2 p) { return (uint)(abs(p.x - goal.x) + abs(p.y - goal.y)); };
+	// Lowest f on top, ties go to the lowest h (closest to the goal)
+	auto greater = [](const OpenEntry& a, const OpenEntry& b) { return a.f != b.f ? a.f > b.f : a.h > b.h; };
+
+	int start_cell = start.y * num_cols + start.x;
+	int goal_cell = goal.y * num_cols + goal.x;
+
+	open_heap.clear();
+	seen[start_cell] = generation;
+	cost[start_cell] = 0;
+	parent[start_cell] = -1;
+	open_heap.push_back({ heuristic(start), heuristic(start), start_cell });
+
+	while (!open_heap.empty()) {
+		std::pop_heap(open_heap.begin(), open_heap.end(), greater);
+		int cell = open_heap.back().cell;
+		open_heap.pop_back();
+
+		if (closed[cell] == generation) continue;
+		closed[cell] = generation;
+		perf_stats.count(PERF_COUNTER::PATH_EXPANSIONS);
+
+		if (cell == goal_cell) {
+			for (int c = goal_cell; c != -1; c = parent[c]) {
+				path.push_back({ c % num_cols, c / num_cols });
+			}
+			return true;
+		}
+
+		ivec2 position = { cell % num_cols, cell / num_cols };
+		for (ivec2 dir : { ivec2(-1, 0), ivec2(1, 0), ivec2(0, -1), ivec2(0, 1) }) {
+			ivec2 neighbor = position + dir;
+			if (!in_bounds(neighbor) || isCellOccupied(neighbor)) continue;
+
+			int neighbor_cell = neighbor.y * num_cols + neighbor.x;
+			if (closed[neighbor_cell] == generation) continue;
+
+			uint g = cost[cell] + 1;
+			if (seen[neighbor_cell] != generation || g < cost[neighbor_cell]) {
+				seen[neighbor_cell] = generation;
+				cost[neighbor_cell] = g;
+				parent[neighbor_cell] = cell;
+				uint h = heuristic(neighbor);
+				open_heap.push_back({ g + h, h, neighbor_cell });
+				std::push_heap(open_heap.begin(), open_heap.end(), greater);
+			}
+		}
+	}
+	return false;
+}
+
+void FlowField::update(ivec2 new_target) {
+	PROFILE_SCOPE("FlowField::update");
+	if (!built || new_target != target) {
+		target = new_target;
+		rebuild();
+		return;
+	}
+	if (grid_version == registry.grid.blocking_version()) {
+		return;
+	}
+
+	changed_cells.clear();
+	bool target_changed = false;
+	if (registry.grid.blocking_changes_since(grid_version, changed_cells)) {
+		for (std::pair<int, int> cell : changed_cells) {
+			target_changed |= (ivec2(cell.first, cell.second) == target);
+		}
+	}
+	// Fall back to a full rebuild if the log does not cover our version (e.g. a new level was loaded)
+	if (changed_cells.empty() || target_changed) {
+		rebuild();
+		return;
+	}
+	grid_version = registry.grid.blocking_version();
+	repair();
+}
+
+void FlowField::rebuild() {
+	num_rows = registry.grid.rows();
+	num_cols = registry.grid.cols();
+	grid_version = registry.grid.blocking_version();
+	built = true;
+
+	distance.assign((size_t)num_rows * num_cols, UNREACHABLE);
+	if (target.x < 0 || target.y < 0 || target.x >= num_cols || target.y >= num_rows || isCellOccupied(target)) {
+		return;
+	}
+
+	frontier.clear();
+	int target_cell = target.y * num_cols + target.x;
+	distance[target_cell] = 0;
+	frontier.push_back(target_cell);
+
+	for (size_t head = 0; head < frontier.size(); head++) {
+		int cell = frontier[head];
+		ivec2 position = { cell % num_cols, cell / num_cols };
+		for (ivec2 dir : { ivec2(-1, 0), ivec2(1, 0), ivec2(0, -1), ivec2(0, 1) }) {
+			ivec2 neighbor = position + dir;
+			if (neighbor.x < 0 || neighbor.y < 0 || neighbor.x >= num_cols || neighbor.y >= num_rows) continue;
+
+			int neighbor_cell = neighbor.y * num_cols + neighbor.x;
+			if (distance[neighbor_cell] != UNREACHABLE || isCellOccupied(neighbor)) continue;
+
+			distance[neighbor_cell] = distance[cell] + 1;
+			frontier.push_back(neighbor_cell);
+		}
+	}
+	perf_stats.count(PERF_COUNTER::PATH_EXPANSIONS, frontier.size());
+}
+
+// Incremental update for the cells in changed_cells:
+// 1. Raise: newly blocked cells lose their distance, and so does every cell whose only shortest-path
+//    neighbors (distance one less) lost theirs. Candidates are handled in order of their old distance,
+//    so a cell's neighbors one level closer are always settled before it is checked.
+// 2. Lower: every cell that lost its distance or was freed is reseeded from its settled neighbors,
+//    then improvements are propagated outwards, Dijkstra-style.
+void FlowField::repair() {
+	auto in_bounds = [this](ivec2 p) { return p.x >= 0 && p.y >= 0 && p.x < num_cols && p.y < num_rows; };
+	auto cell_of = [this](ivec2 p) { return p.y * num_cols + p.x; };
+	const ivec2 directions[] = { ivec2(-1, 0), ivec2(1, 0), ivec2(0, -1), ivec2(0, 1) };
+	auto greater = [](const std::pair<uint, int>& a, const std::pair<uint, int>& b) { return a.first > b.first; };
+
+	if (invalid.size() != distance.size()) {
+		invalid.assign(distance.size(), 0);
+		repair_stamp = 0;
+	}
+	if (++repair_stamp == 0) {
+		std::fill(invalid.begin(), invalid.end(), 0);
+		repair_stamp = 1;
+	}
+
+	// Raise
+	frontier.clear();
+	repair_heap.clear();
+	for (std::pair<int, int> c : changed_cells) {
+		ivec2 p = { c.first, c.second };
+		if (isCellOccupied(p) && distance[cell_of(p)] != UNREACHABLE) {
+			repair_heap.push_back({ distance[cell_of(p)], cell_of(p) });
+		}
+	}
+	std::make_heap(repair_heap.begin(), repair_heap.end(), greater);
+	while (!repair_heap.empty()) {
+		std::pop_heap(repair_heap.begin(), repair_heap.end(), greater);
+		int cell = repair_heap.back().second;
+		repair_heap.pop_back();
+		if (invalid[cell] == repair_stamp) continue;
+		perf_stats.count(PERF_COUNTER::PATH_EXPANSIONS);
+
+		ivec2 position = { cell % num_cols, cell / num_cols };
+		bool supported = false;
+		if (!isCellOccupied(position)) {
+			for (ivec2 dir : directions) {
+				ivec2 neighbor = position + dir;
+				if (!in_bounds(neighbor)) continue;
+				int neighbor_cell = cell_of(neighbor);
+				if (invalid[neighbor_cell] != repair_stamp && distance[neighbor_cell] + 1 == distance[cell]) {
+					supported = true;
+					break;
+				}
+			}
+		}
+		if (supported) continue;
+
+		invalid[cell] = repair_stamp;
+		frontier.push_back(cell);
+		for (ivec2 dir : directions) {
+			ivec2 neighbor = position + dir;
+			if (!in_bounds(neighbor)) continue;
+			int neighbor_cell = cell_of(neighbor);
+			if (invalid[neighbor_cell] != repair_stamp && distance[neighbor_cell] == distance[cell] + 1) {
+				repair_heap.push_back({ distance[neighbor_cell], neighbor_cell });
+				std::push_heap(repair_heap.begin(), repair_heap.end(), greater);
+			}
+		}
+	}
+
+	// Lower. frontier holds the cells to reseed: everything invalidated plus the freed cells
+	for (int cell : frontier) {
+		distance[cell] = UNREACHABLE;
+	}
+	for (std::pair<int, int> c : changed_cells) {
+		ivec2 p = { c.first, c.second };
+		if (!isCellOccupied(p)) {
+			distance[cell_of(p)] = UNREACHABLE;
+			frontier.push_back(cell_of(p));
+		}
+	}
+
+	repair_heap.clear();
+	for (int cell : frontier) {
+		ivec2 position = { cell % num_cols, cell / num_cols };
+		if (isCellOccupied(position)) continue;
+		for (ivec2 dir : directions) {
+			ivec2 neighbor = position + dir;
+			if (in_bounds(neighbor) && distance[cell_of(neighbor)] != UNREACHABLE) {
+				distance[cell] = std::min(distance[cell], distance[cell_of(neighbor)] + 1);
+			}
+		}
+		if (distance[cell] != UNREACHABLE) {
+			repair_heap.push_back({ distance[cell], cell });
+		}
+	}
+	std::make_heap(repair_heap.begin(), repair_heap.end(), greater);
+	while (!repair_heap.empty()) {
+		std::pop_heap(repair_heap.begin(), repair_heap.end(), greater);
+		auto [d, cell] = repair_heap.back();
+		repair_heap.pop_back();
+		if (d > distance[cell]) continue;
+		perf_stats.count(PERF_COUNTER::PATH_EXPANSIONS);
+
+		ivec2 position = { cell % num_cols, cell / num_cols };
+		for (ivec2 dir : directions) {
+			ivec2 neighbor = position + dir;
+			if (!in_bounds(neighbor) || isCellOccupied(neighbor)) continue;
+			int neighbor_cell = cell_of(neighbor);
+			if (d + 1 < distance[neighbor_cell]) {
+				distance[neighbor_cell] = d + 1;
+				repair_heap.push_back({ d + 1, neighbor_cell });
+				std::push_heap(repair_heap.begin(), repair_heap.end(), greater);
+			}
+		}
+	}
+}
+
+uint FlowField::distanceAt(ivec2 cell) const {
+	if (cell.x < 0 || cell.y < 0 || cell.x >= num_cols || cell.y >= num_rows) {
+		return UNREACHABLE;
+	}
+	return distance[cell.y * num_cols + cell.x];
+}
+
+bool FlowField::nextStep(ivec2 cell, ivec2& next) const {
+	if (cell == target) {
+		return false;
+	}
+	// Descend the gradient. The cell itself may be blocked (e.g. an enemy standing in fire), so only its neighbors are looked at
+	uint best = UNREACHABLE;
+	for (ivec2 dir : { ivec2(-1, 0), ivec2(1, 0), ivec2(0, -1), ivec2(0, 1) }) {
+		uint d = distanceAt(cell + dir);
+		if (d < best) {
+			best = d;
+			next = cell + dir;
+		}
+	}
+	return best != UNREACHABLE;
+}
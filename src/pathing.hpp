@@ -1,19 +1,79 @@
-#pragma once
-
-#include "common.hpp"
-
-//  simple A-star node
-struct Node {
-	ivec2 position;
-	ivec2 parent;
-	uint G, H, F;
-
-	Node(ivec2 position_, ivec2 parent_, uint g_, uint h_) : position(position_), parent(parent_), G(g_), H(h_) { F = G + H; };
-
-	uint get_score() { return G + H; }
-	
-	bool operator==(const Node& rhs) { return this->position == rhs.position; }
-
-	bool operator==(const ivec2& pos) { return this->position == pos; }
-};
-
+#pragma once
+
+#include <vector>
+#include "common.hpp"
+
+// Reusable A* search over the map grid for one-off paths. Chasing enemies read a FlowField instead, even a lone
+// chaser, "bench pathing" and "bench firechain" compare the two.
+// All per-cell state lives in flat arrays indexed by cell id (y * num_cols + x) and is stamped with the
+// generation of the search that wrote it, so nothing is cleared or allocated between searches.
+class PathSearch
+{
+public:
+	// Finds a shortest 4-connected path from start to goal, the map size is taken from registry.grid.
+	// On success the path is written to path from goal back to start (both included), so the next
+	// step is path[path.size()-2]. Returns false if goal is unreachable.
+	bool findPath(ivec2 start, ivec2 goal, bool (*isCellOccupied)(ivec2 position), std::vector<ivec2>& path);
+
+private:
+	struct OpenEntry {
+		uint f, h;
+		int cell;
+	};
+
+	int num_rows = 0;
+	int num_cols = 0;
+	uint generation = 0;
+
+	std::vector<uint> seen;		// generation in which the cell's cost and parent were last written
+	std::vector<uint> closed;	// generation in which the cell was expanded
+	std::vector<uint> cost;
+	std::vector<int> parent;
+	std::vector<OpenEntry> open_heap;	// binary min-heap on (f, h), stale entries are skipped when popped
+
+	void resize(int rows, int cols);
+};
+
+// Distance field toward a single target cell (the player), shared by every enemy using the same passability rule.
+// The breadth-first search is only redone when the target changes cell. Obstacle/fire cells appearing or
+// disappearing are read from the grid's change log and only the affected part of the field is repaired,
+// giving the same distances as a full rebuild. Every enemy reads its next step in O(1).
+// The passability rule may only depend on the BLOCKING_GRID_LAYERS of registry.grid.
+class FlowField
+{
+public:
+	static constexpr uint UNREACHABLE = ~0u;
+
+	FlowField(bool (*isCellOccupied)(ivec2 position)) : isCellOccupied(isCellOccupied) {}
+
+	// Rebuilds the field if it is stale for the given target
+	void update(ivec2 target);
+
+	// Neighbor of cell that is one step closer to the target.
+	// Returns false if cell is the target or the target cannot be reached from it.
+	bool nextStep(ivec2 cell, ivec2& next) const;
+
+	// Number of steps from cell to the target, UNREACHABLE if there is no path
+	uint distanceAt(ivec2 cell) const;
+
+private:
+	bool (*isCellOccupied)(ivec2 position);
+
+	int num_rows = 0;
+	int num_cols = 0;
+	ivec2 target = { -1, -1 };
+	bool built = false;
+	unsigned int grid_version = 0;	// registry.grid.blocking_version() the field was built against
+
+	std::vector<uint> distance;
+	std::vector<int> frontier;	// BFS queue, reused between rebuilds
+
+	// Scratch state of repair(), reused between calls
+	std::vector<std::pair<int, int>> changed_cells;
+	std::vector<uint> invalid;	// repair_stamp if the cell lost its distance in the current repair
+	uint repair_stamp = 0;
+	std::vector<std::pair<uint, int>> repair_heap;	// (distance, cell) min-heap
+
+	void rebuild();
+	void repair();
+};
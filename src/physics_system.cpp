@@ -1,8 +1,17 @@
 // internal
 #include "physics_system.hpp"
 #include "world_init.hpp"
+#include "utils/profiler.hpp"
+#include <algorithm>
+#include <climits>
 #include <iostream>
 
+// SSE is part of every x86-64 target, other targets (e.g. Apple silicon) use the scalar path
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define PHYSICS_USE_SSE
+#include <xmmintrin.h>
+#endif
+
 // Returns the local bounding coordinates scaled by the current size of the entity
 vec2 get_bounding_box(const Motion& motion)
 {
@@ -36,60 +45,330 @@ bool collides(const Motion& motion1, const Motion& motion2)
 		motion1.position.y+motion1.hitbox.y/2.0f > motion2.position.y-motion2.hitbox.y/2.0f;
 }
 
-// Checks every triangle for intersection rather than convex hull; inefficient
-// Assumes triangle mesh and ignores Z-axis
+// Separating axis test of a triangle against an axis-aligned box, touching counts as overlapping
+static bool triangle_box_overlap(const MeshTriangle& t, vec2 box_min, vec2 box_max)
+{
+	// Box axes
+	if (std::max(t.a.x, std::max(t.b.x, t.c.x)) < box_min.x || std::min(t.a.x, std::min(t.b.x, t.c.x)) > box_max.x) return false;
+	if (std::max(t.a.y, std::max(t.b.y, t.c.y)) < box_min.y || std::min(t.a.y, std::min(t.b.y, t.c.y)) > box_max.y) return false;
+
+	// Edge normals of the triangle
+	vec2 box_center = (box_min + box_max) / 2.0f;
+	vec2 box_half = (box_max - box_min) / 2.0f;
+	const vec2 edges[3][2] = { { t.a, t.b }, { t.b, t.c }, { t.c, t.a } };
+	for (const auto& edge : edges) {
+		vec2 normal = { edge[1].y - edge[0].y, edge[0].x - edge[1].x };
+		float pa = dot(normal, t.a), pb = dot(normal, t.b), pc = dot(normal, t.c);
+		float center = dot(normal, box_center);
+		float radius = box_half.x * abs(normal.x) + box_half.y * abs(normal.y);
+		if (std::max(pa, std::max(pb, pc)) < center - radius || std::min(pa, std::min(pb, pc)) > center + radius) return false;
+	}
+	return true;
+}
+
+// Tests the box against the mesh triangles, using the BVH built at load (see Mesh::buildCollisionBVH).
+// Mesh colliders are only scaled and translated, so the box stays axis aligned in mesh-local space. Ignores the z axis.
 bool mesh_bounding_box_collides(const Mesh& mesh, const Motion& mesh_motion, const Motion& box) {
-	assert(mesh.vertex_indices.size() % 3 == 0 && "ERROR: Non-triangle mesh passed!");
-	float box_left	 = box.position.x-box.hitbox.x/2.0f;
-	float box_right  = box.position.x+box.hitbox.x/2.0f;
-	float box_top	 = box.position.y+box.hitbox.y/2.0f;
-	float box_bottom = box.position.y-box.hitbox.y/2.0f;
-	std::array<vec2, 4> box_vert = {vec2{ box_left, box_top },
-									vec2{ box_right, box_top },
-									vec2{ box_left, box_bottom },
-									vec2{ box_right, box_bottom }};
-	
-	// If not within bounding boxes, we know there's no collision
-	if (!(mesh_motion.position.x+mesh_motion.scale.x/2.0f > box_left &&
-		  mesh_motion.position.x-mesh_motion.scale.x/2.0f < box_right &&
-		  mesh_motion.position.y-mesh_motion.scale.y/2.0f < box_top &&
-		  mesh_motion.position.y+mesh_motion.scale.y/2.0f > box_bottom))
-		  return false;
-	
-	for (size_t a = 2; a < mesh.vertex_indices.size(); a += 3) {
-		uint16_t i = mesh.vertex_indices[a-2];
-		uint16_t j = mesh.vertex_indices[a-1];
-		uint16_t k = mesh.vertex_indices[a];
-		vec2 vert_i = { mesh.vertices[i].position.x*mesh_motion.scale.x+mesh_motion.position.x,
-						mesh.vertices[i].position.y*mesh_motion.scale.y+mesh_motion.position.y };
-		vec2 vert_j = { mesh.vertices[j].position.x*mesh_motion.scale.x+mesh_motion.position.x,
-						mesh.vertices[j].position.y*mesh_motion.scale.y+mesh_motion.position.y };
-		vec2 vert_k = { mesh.vertices[k].position.x*mesh_motion.scale.x+mesh_motion.position.x,
-						mesh.vertices[k].position.y*mesh_motion.scale.y+mesh_motion.position.y };
-		
-		// If any of the triangle vertices are within the bounding box
-		if (box_left <= vert_i.x && vert_i.x <= box_right && box_bottom <= vert_i.y && vert_i.y <= box_top) { return true; }
-		if (box_left <= vert_j.x && vert_j.x <= box_right && box_bottom <= vert_j.y && vert_j.y <= box_top) { return true; }
-		if (box_left <= vert_k.x && vert_k.x <= box_right && box_bottom <= vert_k.y && vert_k.y <= box_top) { return true; }
-
-		// If any of the bounding box vertices are within the triangle (https://www.jeffreythompson.org/collision-detection/tri-point.php)
-		float triangle_area = abs((vert_j.x-vert_i.x)*(vert_k.y-vert_i.y)-(vert_k.x-vert_i.x)*(vert_j.y-vert_i.y));
-		for (vec2 vert : box_vert) {
-			float area1 = abs((vert_i.x-vert.x)*(vert_j.y-vert.y) - (vert_j.x-vert.x)*(vert_i.y-vert.y));
-			float area2 = abs((vert_j.x-vert.x)*(vert_k.y-vert.y) - (vert_k.x-vert.x)*(vert_j.y-vert.y));
-			float area3 = abs((vert_k.x-vert.x)*(vert_i.y-vert.y) - (vert_i.x-vert.x)*(vert_k.y-vert.y));
-			if (area1+area2+area3 == triangle_area) { return true; }
+	if (mesh.collision_bvh.empty() || mesh_motion.scale.x == 0.0f || mesh_motion.scale.y == 0.0f)
+		return false;
+	vec2 corner_1 = (box.position - box.hitbox/2.0f - mesh_motion.position) / mesh_motion.scale;
+	vec2 corner_2 = (box.position + box.hitbox/2.0f - mesh_motion.position) / mesh_motion.scale;
+	vec2 box_min = min(corner_1, corner_2);	// a negative scale mirrors the box
+	vec2 box_max = max(corner_1, corner_2);
+
+	// Only descend into nodes overlapping the box, a median split BVH over 16 bit indexed triangles is far shallower than the stack
+	unsigned int stack[64];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		const MeshBVHNode& node = mesh.collision_bvh[stack[--top]];
+		if (node.max.x < box_min.x || node.min.x > box_max.x || node.max.y < box_min.y || node.min.y > box_max.y)
+			continue;
+		if (node.count > 0) {
+			for (unsigned int t = node.first; t < node.first + node.count; t++)
+				if (triangle_box_overlap(mesh.collision_triangles[t], box_min, box_max))
+					return true;
+			continue;
 		}
-		
-		// TODO check for line intersections
+		stack[top++] = node.first;
+		stack[top++] = node.first + 1;
 	}
 	return false;
 }
 
-void PhysicsSystem::init(RenderSystem* renderer) { this->renderer = renderer; }
+void PhysicsSystem::init(MeshLibrary* meshes) { this->meshes = meshes; }
+
+void PhysicsSystem::setLayersCollide(COLLISION_LAYER a, COLLISION_LAYER b, bool collide)
+{
+	if (collide) {
+		collision_masks[(int)a] |= 1u << (int)b;
+		collision_masks[(int)b] |= 1u << (int)a;
+	} else {
+		collision_masks[(int)a] &= ~(1u << (int)b);
+		collision_masks[(int)b] &= ~(1u << (int)a);
+	}
+}
+
+// Upper bound on the broadphase bucket grid size
+const long long MAX_BROADPHASE_BUCKETS = 1 << 20;
+
+// Computes the bucket range covered by a motion: its hitbox, grown to the mesh bounds for mesh colliders
+// (see mesh_bounding_box_collides). Bounds are treated as closed, so touching bodies still end up in a common bucket.
+static void compute_bucket_range(const Motion& motion, bool mesh_collider, int& min_x, int& min_y, int& max_x, int& max_y)
+{
+	vec2 half_extent = abs(motion.hitbox) / 2.0f;
+	if (mesh_collider) {
+		half_extent = max(half_extent, abs(motion.scale) / 2.0f);
+	}
+	vec2 lo = motion.position - half_extent;
+	vec2 hi = motion.position + half_extent;
+	min_x = (int)floor(lo.x / GRID_CELL_WIDTH_PX);
+	min_y = (int)floor(lo.y / GRID_CELL_HEIGHT_PX);
+	max_x = (int)floor(hi.x / GRID_CELL_WIDTH_PX);
+	max_y = (int)floor(hi.y / GRID_CELL_HEIGHT_PX);
+}
+
+// Counting sort of bodies into a cols x rows grid of buckets starting at (grid_min_x, grid_min_y)
+void PhysicsSystem::fillBuckets(const std::vector<BroadphaseBody>& bodies, int grid_min_x, int grid_min_y, long long cols, long long rows,
+								std::vector<uint>& bucket_start, std::vector<uint>& bucket_bodies)
+{
+	bucket_start.assign((size_t)cols * rows + 1, 0);
+	for (const BroadphaseBody& body : bodies)
+		for (int y = body.min_y; y <= body.max_y; y++)
+			for (int x = body.min_x; x <= body.max_x; x++)
+				bucket_start[(size_t)(y - grid_min_y) * cols + (x - grid_min_x) + 1]++;
+	for (size_t b = 1; b < bucket_start.size(); b++)
+		bucket_start[b] += bucket_start[b - 1];
+
+	// bucket_start doubles as the write cursor of each bucket
+	bucket_bodies.resize(bucket_start.back());
+	for (uint k = 0; k < bodies.size(); k++) {
+		const BroadphaseBody& body = bodies[k];
+		for (int y = body.min_y; y <= body.max_y; y++)
+			for (int x = body.min_x; x <= body.max_x; x++)
+				bucket_bodies[bucket_start[(size_t)(y - grid_min_y) * cols + (x - grid_min_x)]++] = k;
+	}
+	// The fill pass advanced every start to the next bucket's start, shift back
+	for (size_t b = bucket_start.size() - 1; b > 0; b--)
+		bucket_start[b] = bucket_start[b - 1];
+	bucket_start[0] = 0;
+}
+
+void PhysicsSystem::findCandidatePairs()
+{
+	ComponentContainer<Motion>& motion_container = registry.motions;
+	bodies.clear();
+	candidate_pairs.clear();
+
+	size_t motion_count = motion_container.components.size();
+	aabb_min_x.resize(motion_count);
+	aabb_min_y.resize(motion_count);
+	aabb_max_x.resize(motion_count);
+	aabb_max_y.resize(motion_count);
+
+	for (uint i = 0; i < motion_count; i++)
+	{
+		const Motion& motion = motion_container.components[i];
+		Entity entity = motion_container.entities[i];
+		if (!motion.collidable) continue;
+
+		// Same arithmetic as collides(), so the batched test gives identical results
+		if (motion.hitbox.x > 0.0f && motion.hitbox.y > 0.0f) {
+			aabb_min_x[i] = motion.position.x - motion.hitbox.x/2.0f;
+			aabb_min_y[i] = motion.position.y - motion.hitbox.y/2.0f;
+			aabb_max_x[i] = motion.position.x + motion.hitbox.x/2.0f;
+			aabb_max_y[i] = motion.position.y + motion.hitbox.y/2.0f;
+		} else {
+			aabb_min_x[i] = aabb_min_y[i] = INFINITY;
+			aabb_max_x[i] = aabb_max_y[i] = -INFINITY;
+		}
+
+		// Bodies whose layer collides with nothing never enter the broadphase
+		if (collision_masks[(int)motion.collision_layer] == 0 || registry.staticBodies.has(entity)) continue;
+
+		BroadphaseBody body;
+		body.index = i;
+		body.layer = motion.collision_layer;
+		compute_bucket_range(motion, registry.meshColliders.has(entity), body.min_x, body.min_y, body.max_x, body.max_y);
+		bodies.push_back(body);
+	}
+
+	findDynamicPairs();
+	findStaticPairs();
+
+	// Same pair order as testing every (i, j) with i < j
+	std::sort(candidate_pairs.begin(), candidate_pairs.end());
+}
+
+void PhysicsSystem::findDynamicPairs()
+{
+	if (bodies.size() < 2) return;
+
+	int grid_min_x = INT_MAX, grid_min_y = INT_MAX, grid_max_x = INT_MIN, grid_max_y = INT_MIN;
+	for (const BroadphaseBody& body : bodies) {
+		grid_min_x = std::min(grid_min_x, body.min_x);
+		grid_min_y = std::min(grid_min_y, body.min_y);
+		grid_max_x = std::max(grid_max_x, body.max_x);
+		grid_max_y = std::max(grid_max_y, body.max_y);
+	}
+
+	// Bucket the bodies over the bounding grid of all bodies
+	long long cols = (long long)grid_max_x - grid_min_x + 1;
+	long long rows = (long long)grid_max_y - grid_min_y + 1;
+	if (cols * rows > MAX_BROADPHASE_BUCKETS) {
+		// Bodies spread far outside any level, testing every pair is cheaper than a huge bucket grid
+		for (uint p = 0; p < bodies.size(); p++)
+			for (uint q = p + 1; q < bodies.size(); q++)
+				if (layersCollide(bodies[p].layer, bodies[q].layer))
+					candidate_pairs.push_back({ bodies[p].index, bodies[q].index });
+		return;
+	}
+	fillBuckets(bodies, grid_min_x, grid_min_y, cols, rows, bucket_start, bucket_bodies);
+
+	// Test pairs within each bucket. A pair sharing several buckets is only reported from the first one,
+	// the bucket at the low corner of the overlap of their ranges.
+	for (int y = 0; y < rows; y++) {
+		for (int x = 0; x < cols; x++) {
+			size_t b = (size_t)y * cols + x;
+			for (uint p = bucket_start[b]; p < bucket_start[b + 1]; p++) {
+				const BroadphaseBody& a = bodies[bucket_bodies[p]];
+				for (uint q = p + 1; q < bucket_start[b + 1]; q++) {
+					const BroadphaseBody& c = bodies[bucket_bodies[q]];
+					if (!layersCollide(a.layer, c.layer)) continue;
+					if (std::max(a.min_x, c.min_x) - grid_min_x != x || std::max(a.min_y, c.min_y) - grid_min_y != y) continue;
+					candidate_pairs.push_back({ std::min(a.index, c.index), std::max(a.index, c.index) });
+				}
+			}
+		}
+	}
+}
+
+void PhysicsSystem::rebuildStaticBuckets()
+{
+	ComponentContainer<Motion>& motion_container = registry.motions;
+	static_entities = registry.staticBodies.entities;
+	static_bodies.clear();
+	static_cols = static_rows = 0;
+
+	int grid_min_x = INT_MAX, grid_min_y = INT_MAX, grid_max_x = INT_MIN, grid_max_y = INT_MIN;
+	for (uint s = 0; s < static_entities.size(); s++)
+	{
+		const Motion* motion = motion_container.try_get(static_entities[s]);
+		if (motion == nullptr || !motion->collidable) continue;
+
+		BroadphaseBody body;
+		body.index = s;
+		body.layer = motion->collision_layer;
+		compute_bucket_range(*motion, registry.meshColliders.has(static_entities[s]), body.min_x, body.min_y, body.max_x, body.max_y);
+		static_bodies.push_back(body);
+
+		grid_min_x = std::min(grid_min_x, body.min_x);
+		grid_min_y = std::min(grid_min_y, body.min_y);
+		grid_max_x = std::max(grid_max_x, body.max_x);
+		grid_max_y = std::max(grid_max_y, body.max_y);
+	}
+	if (static_bodies.empty()) return;
+
+	long long cols = (long long)grid_max_x - grid_min_x + 1;
+	long long rows = (long long)grid_max_y - grid_min_y + 1;
+	if (cols * rows > MAX_BROADPHASE_BUCKETS) return;	// leaves static_cols at 0, every dynamic body is paired with every static one
+	fillBuckets(static_bodies, grid_min_x, grid_min_y, cols, rows, static_bucket_start, static_bucket_bodies);
+	static_min_x = grid_min_x;
+	static_min_y = grid_min_y;
+	static_cols = (int)cols;
+	static_rows = (int)rows;
+}
+
+void PhysicsSystem::findStaticPairs()
+{
+	// Static bodies only change when the level is (un)loaded
+	const std::vector<Entity>& current = registry.staticBodies.entities;
+	if (current.size() != static_entities.size() ||
+		!std::equal(current.begin(), current.end(), static_entities.begin(), [](Entity a, Entity b) { return a.id() == b.id(); }))
+		rebuildStaticBuckets();
+	if (static_bodies.empty()) return;
+
+	// Look up the static bodies in every cell a dynamic body covers, static bodies never collide with each other
+	ComponentContainer<Motion>& motion_container = registry.motions;
+	auto add_pair = [&](const BroadphaseBody& a, const BroadphaseBody& c) {
+		if (!layersCollide(a.layer, c.layer)) return;
+		uint i = a.index;
+		const Motion* static_motion = motion_container.try_get(static_entities[c.index]);
+		if (static_motion == nullptr) return;
+		uint j = (uint)(static_motion - motion_container.components.data());
+		candidate_pairs.push_back({ std::min(i, j), std::max(i, j) });
+	};
+	if (static_cols == 0) {
+		for (const BroadphaseBody& a : bodies)
+			for (const BroadphaseBody& c : static_bodies)
+				add_pair(a, c);
+		return;
+	}
+
+	for (const BroadphaseBody& a : bodies) {
+		int from_x = std::max(a.min_x, static_min_x), to_x = std::min(a.max_x, static_min_x + static_cols - 1);
+		int from_y = std::max(a.min_y, static_min_y), to_y = std::min(a.max_y, static_min_y + static_rows - 1);
+		for (int y = from_y; y <= to_y; y++) {
+			for (int x = from_x; x <= to_x; x++) {
+				size_t b = (size_t)(y - static_min_y) * static_cols + (x - static_min_x);
+				for (uint p = static_bucket_start[b]; p < static_bucket_start[b + 1]; p++) {
+					const BroadphaseBody& c = static_bodies[static_bucket_bodies[p]];
+					if (std::max(a.min_x, c.min_x) != x || std::max(a.min_y, c.min_y) != y) continue;
+					add_pair(a, c);
+				}
+			}
+		}
+	}
+}
+
+void PhysicsSystem::testCandidateAABBs()
+{
+	candidate_hits.resize(candidate_pairs.size());
+
+	// Pairs are sorted, so each run of pairs shares its first body
+	size_t run_start = 0;
+	while (run_start < candidate_pairs.size()) {
+		uint i = candidate_pairs[run_start].first;
+		size_t run_end = run_start + 1;
+		while (run_end < candidate_pairs.size() && candidate_pairs[run_end].first == i)
+			run_end++;
+
+		size_t k = run_start;
+#ifdef PHYSICS_USE_SSE
+		const __m128 i_min_x = _mm_set1_ps(aabb_min_x[i]);
+		const __m128 i_min_y = _mm_set1_ps(aabb_min_y[i]);
+		const __m128 i_max_x = _mm_set1_ps(aabb_max_x[i]);
+		const __m128 i_max_y = _mm_set1_ps(aabb_max_y[i]);
+		for (; k + 4 <= run_end; k += 4) {
+			uint j0 = candidate_pairs[k].second, j1 = candidate_pairs[k+1].second;
+			uint j2 = candidate_pairs[k+2].second, j3 = candidate_pairs[k+3].second;
+			__m128 j_min_x = _mm_setr_ps(aabb_min_x[j0], aabb_min_x[j1], aabb_min_x[j2], aabb_min_x[j3]);
+			__m128 j_min_y = _mm_setr_ps(aabb_min_y[j0], aabb_min_y[j1], aabb_min_y[j2], aabb_min_y[j3]);
+			__m128 j_max_x = _mm_setr_ps(aabb_max_x[j0], aabb_max_x[j1], aabb_max_x[j2], aabb_max_x[j3]);
+			__m128 j_max_y = _mm_setr_ps(aabb_max_y[j0], aabb_max_y[j1], aabb_max_y[j2], aabb_max_y[j3]);
+			__m128 hit = _mm_and_ps(
+				_mm_and_ps(_mm_cmpgt_ps(i_max_x, j_min_x), _mm_cmplt_ps(i_min_x, j_max_x)),
+				_mm_and_ps(_mm_cmplt_ps(i_min_y, j_max_y), _mm_cmpgt_ps(i_max_y, j_min_y)));
+			int mask = _mm_movemask_ps(hit);
+			candidate_hits[k]   = (mask >> 0) & 1;
+			candidate_hits[k+1] = (mask >> 1) & 1;
+			candidate_hits[k+2] = (mask >> 2) & 1;
+			candidate_hits[k+3] = (mask >> 3) & 1;
+		}
+#endif
+		for (; k < run_end; k++) {
+			uint j = candidate_pairs[k].second;
+			candidate_hits[k] =
+				aabb_max_x[i] > aabb_min_x[j] && aabb_min_x[i] < aabb_max_x[j] &&
+				aabb_min_y[i] < aabb_max_y[j] && aabb_max_y[i] > aabb_min_y[j];
+		}
+		run_start = run_end;
+	}
+}
 
 void PhysicsSystem::step(float elapsed_ms)
 {
+	PROFILE_SYSTEM_SCOPE("PhysicsSystem::step", PERF_SYSTEM::PHYSICS);
 	// for (int i = registry.highlightBlocks.size()-1; i >= 0; i--) {
 	// 	registry.remove_all_components_of(registry.highlightBlocks.entities[i]);
 	// }
@@ -113,25 +392,16 @@ void PhysicsSystem::step(float elapsed_ms)
 		std::pair<int, int> down_edge_cell	= position_to_grid_coords(motion.position.x, motion.position.y+motion.hitbox.y);
 		std::pair<int, int> curr_cell		= position_to_grid_coords(motion.position);
 
-		if (registry.map_grid_coord_entityID[left_edge_cell].has_value() &&
-			registry.map_grid_coord_entityID[left_edge_cell].value() == entity) {
-				registry.map_grid_coord_entityID[left_edge_cell] = {};
-		}
-		if (registry.map_grid_coord_entityID[right_edge_cell].has_value() &&
-			registry.map_grid_coord_entityID[right_edge_cell].value() == entity) {
-				registry.map_grid_coord_entityID[right_edge_cell] = {};
-		}
-		if (registry.map_grid_coord_entityID[up_edge_cell].has_value() &&
-			registry.map_grid_coord_entityID[up_edge_cell].value() == entity) {
-				registry.map_grid_coord_entityID[up_edge_cell] = {};
-		}
-		if (registry.map_grid_coord_entityID[down_edge_cell].has_value() &&
-			registry.map_grid_coord_entityID[down_edge_cell].value() == entity) {
-				registry.map_grid_coord_entityID[down_edge_cell] = {};
-		}
-		if (registry.map_grid_coord_entityID[curr_cell].has_value() &&
-			registry.map_grid_coord_entityID[curr_cell].value() == entity) {
-				registry.map_grid_coord_entityID[curr_cell] = {};
+		// Only entities tracked on the occupancy grid update it
+		GRID_LAYER layer = registry.grid_layer_of(entity);
+		bool on_grid = layer != GRID_LAYER::GRID_LAYER_COUNT;
+
+		if (on_grid) {
+			registry.grid.unset(left_edge_cell, layer, entity);
+			registry.grid.unset(right_edge_cell, layer, entity);
+			registry.grid.unset(up_edge_cell, layer, entity);
+			registry.grid.unset(down_edge_cell, layer, entity);
+			registry.grid.unset(curr_cell, layer, entity);
 		}
 
 		if(!registry.players.has(entity)) {
@@ -167,55 +437,52 @@ void PhysicsSystem::step(float elapsed_ms)
 				break;
 		}
 
-		if (prev_cell != curr_cell && !registry.map_grid_coord_entityID[prev_cell].has_value()) {
-			registry.map_grid_coord_entityID[prev_cell] = entity;
+		if (!on_grid) continue;
+		if (prev_cell != curr_cell && !registry.grid.has(prev_cell, layer)) {
+			registry.grid.set(prev_cell, layer, entity);
 		}
-		if (next_cell != curr_cell && !registry.map_grid_coord_entityID[next_cell].has_value()) {
-			registry.map_grid_coord_entityID[next_cell] = entity;
+		if (next_cell != curr_cell && !registry.grid.has(next_cell, layer)) {
+			registry.grid.set(next_cell, layer, entity);
 		}
-		if (!registry.map_grid_coord_entityID[curr_cell].has_value()) {
-			registry.map_grid_coord_entityID[curr_cell] = entity;
+		if (!registry.grid.has(curr_cell, layer)) {
+			registry.grid.set(curr_cell, layer, entity);
 		}
 	}
 
-	// check for collisions between all entities
+	// check for collisions between all entities that share a broadphase bucket
+	PROFILE_SCOPE("PhysicsSystem collision pass");
     ComponentContainer<Motion> &motion_container = registry.motions;
-	for (uint i = 0; i < motion_container.components.size(); i++)
+	findCandidatePairs();
+	testCandidateAABBs();
+	for (size_t k = 0; k < candidate_pairs.size(); k++)
 	{
-		Motion& motion_i = motion_container.components[i];
-		if (!motion_i.collidable) continue;
+		std::pair<uint, uint> candidate = candidate_pairs[k];
+		Motion& motion_i = motion_container.components[candidate.first];
+		Motion& motion_j = motion_container.components[candidate.second];
+		Entity entity_i = motion_container.entities[candidate.first];
+		Entity entity_j = motion_container.entities[candidate.second];
 
-		Entity entity_i = motion_container.entities[i];
-		
-		// note starting j at i+1 to compare all (i,j) pairs only once (and to not compare with itself)
-		for (uint j = i+1; j < motion_container.components.size(); j++)
+		// AABB/AABB collision, same test as collides()
+		if (candidate_hits[k])
 		{
-			Motion& motion_j = motion_container.components[j];
-			if (!motion_j.collidable) continue;
-
-			Entity entity_j = motion_container.entities[j];
-			
-			// AABB/AABB collision
-			if (collides(motion_i, motion_j))
-			{
-				// Create a collisions event
-				// We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
-				// CK: why the duplication, except to allow searching by entity_id
+			// Create a collisions event
+			// We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
+			// CK: why the duplication, except to allow searching by entity_id
+			registry.collisions.emplace_with_duplicates(entity_i, entity_j);
+			// registry.collisions.emplace_with_duplicates(entity_j, entity_i);
+		}
+		// MeshCollider/AABB collision
+		else if (registry.meshColliders.has(entity_i) && !registry.meshColliders.has(entity_j)) {
+			const Mesh& m = meshes->get(registry.meshColliders.get(entity_i).geometry);
+			if (mesh_bounding_box_collides(m, motion_i, motion_j)) {
 				registry.collisions.emplace_with_duplicates(entity_i, entity_j);
-				// registry.collisions.emplace_with_duplicates(entity_j, entity_i);
 			}
-			// MeshCollider/AABB collision
-			else if (registry.meshColliders.has(entity_i) && !registry.meshColliders.has(entity_j)) {
-				const Mesh& m = renderer->getMesh(registry.meshColliders.get(entity_i).geometry);
-				if (mesh_bounding_box_collides(m, motion_i, motion_j)) {
-					registry.collisions.emplace_with_duplicates(entity_i, entity_j);
-				}
-			} else if (registry.meshColliders.has(entity_j) && !registry.meshColliders.has(entity_i)) {
-				const Mesh& m = renderer->getMesh(registry.meshColliders.get(entity_j).geometry);
-				if (mesh_bounding_box_collides(m, motion_j, motion_i)) {
-					registry.collisions.emplace_with_duplicates(entity_i, entity_j);
-				}
+		} else if (registry.meshColliders.has(entity_j) && !registry.meshColliders.has(entity_i)) {
+			const Mesh& m = meshes->get(registry.meshColliders.get(entity_j).geometry);
+			if (mesh_bounding_box_collides(m, motion_j, motion_i)) {
+				registry.collisions.emplace_with_duplicates(entity_i, entity_j);
 			}
 		}
 	}
+	perf_stats.count(PERF_COUNTER::COLLISIONS, registry.collisions.size());
 }
\ No newline at end of file
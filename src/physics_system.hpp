@@ -1,7 +1,7 @@
 #pragma once
 
 #include "common.hpp"
-#include "render_system.hpp"
+#include "mesh_library.hpp"
 #include "tinyECS/tiny_ecs.hpp"
 #include "tinyECS/components.hpp"
 #include "tinyECS/registry.hpp"
@@ -13,12 +13,70 @@ bool collides(const Motion& motion1, const Motion& motion2);
 class PhysicsSystem
 {
 private:
-	RenderSystem* renderer;
+	MeshLibrary* meshes = nullptr;	// geometry of the mesh colliders
+
+	// Broadphase: dynamic collidable motions binned into a uniform grid of map-cell sized buckets.
+	// All buffers are rebuilt every step and kept around to avoid reallocating.
+	struct BroadphaseBody {
+		uint index;		// motion index, or index into static_entities for static geometry
+		COLLISION_LAYER layer;
+		int min_x, min_y, max_x, max_y;	// inclusive bucket range covered by the body
+	};
+	std::vector<BroadphaseBody> bodies;
+	std::vector<uint> bucket_start;		// bucket b holds bucket_bodies[bucket_start[b] .. bucket_start[b+1])
+	std::vector<uint> bucket_bodies;	// indices into bodies
+	std::vector<std::pair<uint, uint>> candidate_pairs;	// (i, j) motion indices with i < j
+
+	// Packed AABB extents of the collidable motions, indexed by motion index, for the batched AABB tests.
+	// A motion without a positive hitbox gets an empty box that overlaps nothing.
+	std::vector<float> aabb_min_x, aabb_min_y, aabb_max_x, aabb_max_y;
+	std::vector<uint8_t> candidate_hits;	// AABB test result of each candidate pair
+
+	// Fills candidate_hits, testing each body against its candidates 4 at a time where SSE is available
+	void testCandidateAABBs();
+
+	// Bit b of collision_masks[a] is set if layers a and b are tested against each other
+	std::array<uint32_t, collision_layer_count> collision_masks;
+
+	// Static geometry (StaticBody motions) bucketed the same way, but only rebuilt when the set of static bodies changes
+	std::vector<Entity> static_entities;		// the registry.staticBodies entities the buckets were built from
+	std::vector<BroadphaseBody> static_bodies;	// bounds of the collidable ones
+	std::vector<uint> static_bucket_start;
+	std::vector<uint> static_bucket_bodies;		// indices into static_bodies
+	int static_min_x = 0, static_min_y = 0, static_cols = 0, static_rows = 0;
+
+	// Fills candidate_pairs with every pair of collidable motions whose bounds share a bucket, except static/static pairs
+	void findCandidatePairs();
+	void findDynamicPairs();	// dynamic/dynamic pairs
+	void findStaticPairs();		// dynamic/static pairs, by looking up the cells each dynamic body covers
+	void rebuildStaticBuckets();
+	static void fillBuckets(const std::vector<BroadphaseBody>& bodies, int grid_min_x, int grid_min_y, long long cols, long long rows,
+							std::vector<uint>& bucket_start, std::vector<uint>& bucket_bodies);
+
+	// bench/physics_bench.cpp times the batched AABB test on its own
+	friend struct AABBBench;
+
 public:
-	void init(RenderSystem* renderer);
+	void init(MeshLibrary* meshes);
 	void step(float elapsed_ms);
 
+	// Sets whether entities on the two layers are tested for collisions, pairs that are not never reach the narrowphase
+	void setLayersCollide(COLLISION_LAYER a, COLLISION_LAYER b, bool collide);
+	bool layersCollide(COLLISION_LAYER a, COLLISION_LAYER b) const { return (collision_masks[(int)a] >> (int)b) & 1; }
+
 	PhysicsSystem()
 	{
+		collision_masks.fill(0);
+		for (int layer = 0; layer < collision_layer_count; layer++)
+			setLayersCollide(COLLISION_LAYER::DEFAULT, (COLLISION_LAYER)layer, true);
+
+		// The pairs WorldSystem::handle_collisions reacts to, fire blocks are obstacles to enemies
+		setLayersCollide(COLLISION_LAYER::ENEMY, COLLISION_LAYER::OBSTACLE, true);
+		setLayersCollide(COLLISION_LAYER::ENEMY, COLLISION_LAYER::FIRE, true);
+		setLayersCollide(COLLISION_LAYER::ENEMY, COLLISION_LAYER::ENEMY, true);
+		setLayersCollide(COLLISION_LAYER::PLAYER, COLLISION_LAYER::INGREDIENT, true);
+		setLayersCollide(COLLISION_LAYER::PLAYER, COLLISION_LAYER::POWERUP, true);
+		setLayersCollide(COLLISION_LAYER::PLAYER, COLLISION_LAYER::ENEMY, true);
+		setLayersCollide(COLLISION_LAYER::INGREDIENT, COLLISION_LAYER::FIRE, true);
 	}
 };
\ No newline at end of file
@@ -6,8 +6,10 @@
 // internal
 #include "render_system.hpp"
 #include "tinyECS/registry.hpp"
+#include "utils/profiler.hpp"
 
 void RenderSystem::drawBox(Entity entity, const mat3& projection) {
+	flushSprites();
 
 	Box& box = registry.boxes.get(entity);
 
@@ -21,89 +23,52 @@ void RenderSystem::drawBox(Entity entity, const mat3& projection) {
 	assert(registry.renderRequests.has(entity));
 	const RenderRequest& render_request = registry.renderRequests.get(entity);
 
+	assert(render_request.used_effect == EFFECT_ASSET_ID::BOX && "Type of render request not supported");
 	const GLuint used_effect_enum = (GLuint)render_request.used_effect;
-	assert(used_effect_enum != (GLuint)EFFECT_ASSET_ID::EFFECT_COUNT);
 	const GLuint program = (GLuint)effects[used_effect_enum];
+	const EffectLocations& locations = effect_locations[used_effect_enum];
 
 	// setting shaders
 	glUseProgram(program);
 	gl_has_errors();
 
+	// The vao holds the vertex and index buffers and the attribute setup
 	assert(render_request.used_geometry != GEOMETRY_BUFFER_ID::GEOMETRY_COUNT);
-	const GLuint vbo = vertex_buffers[(GLuint)render_request.used_geometry];
-	const GLuint ibo = index_buffers[(GLuint)render_request.used_geometry];
-
-	// Setting vertex and index buffers
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	const GLuint vao = effect_vaos[used_effect_enum][(GLuint)render_request.used_geometry];
+	assert(vao != 0);
+	glBindVertexArray(vao);
 	gl_has_errors();
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	const vec4* color = registry.colors.try_get(entity);
+	const vec4 fcolor = color != nullptr ? *color : vec4(1);
+	glUniform4fv(locations.fcolor, 1, (float*)&fcolor);
+	glUniformMatrix3fv(locations.transform, 1, GL_FALSE, (float*)&transform.mat);
+	glUniformMatrix3fv(locations.projection, 1, GL_FALSE, (float*)&projection);
 	gl_has_errors();
 
-	if (render_request.used_effect == EFFECT_ASSET_ID::BOX)
-	{
-		GLint in_position_loc = glGetAttribLocation(program, "in_position");
-		gl_has_errors();
-
-		GLint in_color_loc    = glGetAttribLocation(program, "in_color");
-		gl_has_errors();
-
-		glEnableVertexAttribArray(in_position_loc);
-		glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE,
-			sizeof(ColoredVertex), (void*)0);
-		gl_has_errors();
-
-		glEnableVertexAttribArray(in_color_loc);
-		glVertexAttribPointer(in_color_loc, 3, GL_FLOAT, GL_FALSE,
-			sizeof(ColoredVertex), (void*)sizeof(vec3));
-		gl_has_errors();
-	}
-	else
-	{
-		assert(false && "Type of render request not supported");
-	}
-
-	// Getting uniform locations for glUniform* calls
-	GLint color_uloc = glGetUniformLocation(program, "fcolor");
-	const vec4 color = registry.colors.has(entity) ? registry.colors.get(entity) : vec4(1);
-	glUniform4fv(color_uloc, 1, (float*)&color);
-	gl_has_errors();
-
-	// Get number of indices from index buffer, which has elements uint16_t
-	GLint size = 0;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
-	gl_has_errors();
-
-	GLsizei num_indices = size / sizeof(uint16_t);
-
-	GLint currProgram;
-	glGetIntegerv(GL_CURRENT_PROGRAM, &currProgram);
-	// Setting uniform values to the currently bound program
-	GLuint transform_loc = glGetUniformLocation(currProgram, "transform");
-	glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float*)&transform.mat);
-	gl_has_errors();
-
-	GLuint projection_loc = glGetUniformLocation(currProgram, "projection");
-	glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float*)&projection);
-	gl_has_errors();
+	const GLsizei num_indices = index_counts[(GLuint)render_request.used_geometry];
 
 	// Drawing of num_indices/3 triangles specified in the index buffer
+	perf_stats.count(PERF_COUNTER::DRAW_CALLS);
 	glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, nullptr);
 	gl_has_errors();
+
+	glBindVertexArray(global_vao);
 }
 
 /**
- * Activates the instance VAO and initializes the instance VBO to the max size of particles
+ * Uploads the instances of a texture, creating its instance VAO and VBO on first use and growing the VBO as needed
  */
 void RenderSystem::updateInstanceDataVBO(TEXTURE_ASSET_ID tid, std::vector<InstanceItem>& instances)
 {
-	// Bind the instance VBO
-	glBindBuffer(GL_ARRAY_BUFFER, instance_vbos[(uint)tid]);
-	gl_has_errors();
+	PROFILE_SCOPE("RenderSystem instance upload");
+	if (instance_vaos[(uint)tid] == 0) {
+		initInstanceDataVBO(tid);
+	}
 
 	// Build CPU array of InstancedVertex
-	std::vector<InstancedVertex> ivs;
-	ivs.reserve(instances.size());
+	instance_upload.clear();
+	instance_upload.reserve(instances.size());
 
 	for (auto &it : instances)
 	{
@@ -116,12 +81,20 @@ void RenderSystem::updateInstanceDataVBO(TEXTURE_ASSET_ID tid, std::vector<Insta
 		iv.offset = std::move(t.mat);
 		iv.alpha = it.alpha;
 
-		ivs.push_back(iv);
+		instance_upload.push_back(iv);
 	}
 
-	// Update the instance data
-	// Uses glBufferSubData to avoid reallocating entire memory on each iteration
-	glBufferSubData(GL_ARRAY_BUFFER, 0, ivs.size() * sizeof(InstancedVertex), ivs.data());
+	// Bind the instance VBO
+	glBindBuffer(GL_ARRAY_BUFFER, instance_vbos[(uint)tid]);
+	gl_has_errors();
+
+	// Grow geometrically, and orphan the previous contents on every upload so it never waits for the draw still reading them
+	size_t& capacity = instance_capacities[(uint)tid];
+	if (instance_upload.size() > capacity) {
+		capacity = std::max(instance_upload.size(), capacity * 2);
+	}
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(InstancedVertex), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, instance_upload.size() * sizeof(InstancedVertex), instance_upload.data());
 	gl_has_errors();
 
 	// Unbind
@@ -136,6 +109,7 @@ void RenderSystem::renderInstances(TEXTURE_ASSET_ID tid, size_t instanceCount)
 	glBindVertexArray(instance_vaos[(uint)tid]);
 	gl_has_errors();
 
+	perf_stats.count(PERF_COUNTER::DRAW_CALLS);
 	glDrawElementsInstanced(
 			GL_TRIANGLES,        // mode
 			6,                   // index count for a quad
@@ -159,8 +133,9 @@ void RenderSystem::drawTexturedInstance(const mat3 &projection, const InstanceRe
 	gl_has_errors();
 
 	// Pass the projection matrix
-	GLint projection_loc = glGetUniformLocation(program, "projection");
-	glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float*)&projection);
+	const EffectLocations& locations = effect_locations[(GLuint)EFFECT_ASSET_ID::INSTANCED];
+	glUniformMatrix3fv(locations.projection, 1, GL_FALSE, (float*)&projection);
+	glUniform4fv(locations.uv_rect, 1, (float*)&texture_uv_rects[(uint)instance_request.texture]);
 	gl_has_errors();
 
 	// Bind the texture to texture unit 0
@@ -181,6 +156,15 @@ void RenderSystem::drawTexturedInstance(const mat3 &projection, const InstanceRe
 
 void RenderSystem::drawTexturedMesh(Entity entity, const mat3 &projection, uint8_t object_id)
 {
+	assert(registry.renderRequests.has(entity));
+	const RenderRequest &render_request = registry.renderRequests.get(entity);
+	if (isBatchedSprite(render_request)) {
+		queueSprite(entity, projection, object_id);
+		return;
+	}
+	// Anything else is drawn right away, after the sprites queued before it
+	flushSprites();
+
 	// std::cout << "RenderSystem::drawTexturedMesh" << std::endl;
 	Motion &motion = registry.motions.get(entity);
 	// Transformation code, see Rendering and Transformation in the template
@@ -191,167 +175,235 @@ void RenderSystem::drawTexturedMesh(Entity entity, const mat3 &projection, uint8
 	transform.scale(motion.scale);
 	// transform.rotate(radians(motion.angle));
 
-	assert(registry.renderRequests.has(entity));
-	const RenderRequest &render_request = registry.renderRequests.get(entity);
-
+	// .obj entities, everything else is a batched sprite
+	assert(render_request.used_effect == EFFECT_ASSET_ID::MESH && "Type of render request not supported");
 	const GLuint used_effect_enum = (GLuint)render_request.used_effect;
-	assert(used_effect_enum != (GLuint)EFFECT_ASSET_ID::EFFECT_COUNT);
 	const GLuint program = (GLuint)effects[used_effect_enum];
+	const EffectLocations& locations = effect_locations[used_effect_enum];
 
 	// Setting shaders
 	glUseProgram(program);
 	gl_has_errors();
 
+	// The vao holds the vertex and index buffers and the attribute setup
 	assert(render_request.used_geometry != GEOMETRY_BUFFER_ID::GEOMETRY_COUNT);
-	const GLuint vbo = vertex_buffers[(GLuint)render_request.used_geometry];
-	const GLuint ibo = index_buffers[(GLuint)render_request.used_geometry];
+	const GLuint vao = effect_vaos[used_effect_enum][(GLuint)render_request.used_geometry];
+	assert(vao != 0);
+	glBindVertexArray(vao);
+	gl_has_errors();
 
-	// Setting vertex and index buffers
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	const vec4* color = registry.colors.try_get(entity);
+	const vec4 fcolor = color != nullptr ? *color : vec4(1);
+	glUniform4fv(locations.fcolor, 1, (float *)&fcolor);
+	glUniformMatrix3fv(locations.transform, 1, GL_FALSE, (float *)&transform.mat);
+	glUniformMatrix3fv(locations.projection, 1, GL_FALSE, (float *)&projection);
 	gl_has_errors();
 
-	// texture-mapped entities - use data location as in the vertex buffer
-	if (render_request.used_effect == EFFECT_ASSET_ID::TEXTURED ||
-		render_request.used_effect == EFFECT_ASSET_ID::POWERUP ||
-		render_request.used_effect == EFFECT_ASSET_ID::FIRE)
-	{
-		GLint in_position_loc = glGetAttribLocation(program, "in_position");
-		GLint in_texcoord_loc = glGetAttribLocation(program, "in_texcoord");
-		// GLint in_color_loc = glGetAttribLocation(program, "in_color");
-		gl_has_errors();
-		assert(in_texcoord_loc >= 0);
+	const GLsizei num_indices = index_counts[(GLuint)render_request.used_geometry];
 
-		glEnableVertexAttribArray(in_position_loc);
-		glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE,
-								sizeof(TexturedVertex), (void *)0);
-		gl_has_errors();
+	// Drawing of num_indices/3 triangles specified in the index buffer
+	perf_stats.count(PERF_COUNTER::DRAW_CALLS);
+	glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, nullptr);
+	gl_has_errors();
 
-        // Check if EFFECT ID is POWERUP, if so then attach the colors to each vertex, if not only attach texCoords
-        if (render_request.used_effect == EFFECT_ASSET_ID::POWERUP) {
-		    GLint in_color_loc = glGetAttribLocation(program, "in_color");
-            glEnableVertexAttribArray(in_texcoord_loc);
-            glVertexAttribPointer(
-                in_texcoord_loc, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex),
-                (void *)sizeof(
-                    vec3)); // note the stride to skip the preceeding vertex position
-            
-            glEnableVertexAttribArray(in_color_loc);
-            glVertexAttribPointer(
-                in_color_loc, 3, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*)(sizeof(vec3) + sizeof(vec2))
-            );
-
-            // Pass in time as uniform for linear interpolation
-            GLuint time_uloc = glGetUniformLocation(program, "time");
-            glUniform1f(time_uloc, (float)(glfwGetTime() * 10.0f));
-        } else if (render_request.used_effect == EFFECT_ASSET_ID::FIRE) {
-            glEnableVertexAttribArray(in_texcoord_loc);
-            glVertexAttribPointer(
-                in_texcoord_loc, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex),
-                (void *)sizeof(
-                    vec3)); // note the stride to skip the preceeding vertex position
-			
-			// Fire light flickering effect
-			if (registry.fireBlocks.has(entity)) {
-				FireBlock& fire = registry.fireBlocks.get(entity);
-				GLint scale_uloc = glGetUniformLocation(program, "u_scale");
-				glUniform1f(scale_uloc, fire.light_radius);
-			}
-		} else {
-            glEnableVertexAttribArray(in_texcoord_loc);
-            glVertexAttribPointer(
-                in_texcoord_loc, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex),
-                (void *)sizeof(
-                    vec3)); // note the stride to skip the preceeding vertex position
-			
-			// assign normal strength uniform
-			GLint normal_strength_uloc = glGetUniformLocation(program, "normal_strength");
-			if (normal_strength_uloc > -1) glUniform1f(normal_strength_uloc, render_request.used_normal_strength);
-			gl_has_errors();
-        }
+	glBindVertexArray(global_vao);
+}
 
-		GLint object_id_uloc = glGetUniformLocation(program, "object_id");
-		if (object_id_uloc > -1) glUniform1ui(object_id_uloc, object_id);
+void RenderSystem::queueSprite(Entity entity, const mat3& projection, uint8_t object_id)
+{
+	// One projection per batch
+	if (!sprite_quads.empty() && projection != sprite_projection) {
+		flushSprites();
+	}
+	sprite_projection = projection;
 
-		// Enabling and binding texture to slot 0
-		glActiveTexture(GL_TEXTURE0);
-		gl_has_errors();
+	const Motion& motion = registry.motions.get(entity);
+	const RenderRequest& render_request = registry.renderRequests.get(entity);
 
-		assert(registry.renderRequests.has(entity));
-		GLuint texture_id = 
-			texture_gl_handles[(GLuint)registry.renderRequests.get(entity).used_texture];
+	Transform transform;
+	transform.translate(motion.position);
+	transform.scale(motion.scale);
 
-		glBindTexture(GL_TEXTURE_2D, texture_id);
-		gl_has_errors();
+	float param = render_request.used_normal_strength;
+	if (render_request.used_effect == EFFECT_ASSET_ID::FIRE) {
+		// Fire sprites grow with their light radius, the uvs are scaled back in the fragment shader
+		FireBlock* fire = registry.fireBlocks.try_get(entity);
+		param = fire != nullptr ? fire->light_radius : 1.f;
+		transform.mat[0][0] *= param;
+		transform.mat[1][1] *= param;
+	}
 
-		// if normals are used for this RenderRequest, assign the texture
-		if (render_request.used_normal_strength > 0.0f && render_request.used_normal_texture != TEXTURE_ASSET_ID::TEXTURE_COUNT) {
-			glActiveTexture(GL_TEXTURE1);
-			gl_has_errors();
+	vec4* color = registry.colors.try_get(entity);
+	const vec4 fcolor = color != nullptr ? *color : vec4(1);
 
-			assert(registry.renderRequests.has(entity));
-			GLuint normal_texture_id = 
-				texture_gl_handles[(GLuint)render_request.used_normal_texture];
+	const GLuint texture = (GLuint)render_request.used_texture;
+	SpriteQuad quad = { render_request.used_effect, texture_gl_handles[texture], 0 };
+	vec4 normal_uv_rect = vec4(0);
+	if (usesNormalTexture(render_request)) {
+		quad.normal_texture = texture_gl_handles[(GLuint)render_request.used_normal_texture];
+		normal_uv_rect = texture_uv_rects[(GLuint)render_request.used_normal_texture];
+	}
+	sprite_quads.push_back(quad);
 
-			glBindTexture(GL_TEXTURE_2D, normal_texture_id);
-			gl_has_errors();
-			
-			GLint normal_uloc = glGetUniformLocation(program, "normal_sampler");
-			glUniform1i(normal_uloc, 1);
+	for (const TexturedVertex& vertex : sprite_geometry) {
+		vec3 position = transform.mat * vec3(vertex.position.x, vertex.position.y, 1.f);
+		sprite_vertices.push_back({ vec3(position.x, position.y, vertex.position.z), vertex.texcoord, vertex.color, fcolor, param, object_id,
+									texture_uv_rects[texture], normal_uv_rect });
+	}
+}
+
+void RenderSystem::flushSprites(bool any_order)
+{
+	if (sprite_quads.empty()) {
+		return;
+	}
+	PROFILE_SCOPE("RenderSystem::flushSprites");
+
+	const size_t quad_count = sprite_quads.size();
+	orderSpriteBatch(sprite_quads, any_order, sprite_order);
+	sprite_upload.resize(quad_count * 4);
+	for (size_t k = 0; k < quad_count; k++) {
+		std::copy_n(sprite_vertices.begin() + sprite_order[k] * 4, 4, sprite_upload.begin() + k * 4);
+	}
+
+	glBindVertexArray(sprite_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, sprite_vbo);
+	if (quad_count > sprite_buffer_quads) {
+		// Grow both buffers, the index buffer holds the same two triangles per quad as the SPRITE geometry
+		sprite_buffer_quads = std::max(quad_count, sprite_buffer_quads * 2);
+		std::vector<uint32_t> indices(sprite_buffer_quads * 6);
+		for (size_t q = 0; q < sprite_buffer_quads; q++) {
+			const uint32_t base = (uint32_t)q * 4;
+			const uint32_t quad_indices[6] = { base + 0, base + 3, base + 1, base + 1, base + 3, base + 2 };
+			std::copy_n(quad_indices, 6, indices.begin() + q * 6);
+		}
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sprite_ibo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+	}
+	// Orphan the previous contents so the driver does not wait for the draws still using them
+	glBufferData(GL_ARRAY_BUFFER, sprite_buffer_quads * 4 * sizeof(SpriteVertex), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, sprite_upload.size() * sizeof(SpriteVertex), sprite_upload.data());
+	gl_has_errors();
+
+	EFFECT_ASSET_ID current_effect = EFFECT_ASSET_ID::EFFECT_COUNT;
+	forEachSpriteRun(sprite_quads, sprite_order, [&](size_t first, size_t last) {
+		const SpriteQuad& quad = sprite_quads[sprite_order[first]];
+		if (quad.effect != current_effect) {
+			current_effect = quad.effect;
+			const EffectLocations& locations = effect_locations[(GLuint)quad.effect];
+			glUseProgram(effects[(GLuint)quad.effect]);
+			glUniformMatrix3fv(locations.projection, 1, GL_FALSE, (float*)&sprite_projection);
+			if (quad.effect == EFFECT_ASSET_ID::POWERUP) {
+				// Pass in time as uniform for linear interpolation
+				glUniform1f(locations.time, (float)(glfwGetTime() * 10.0f));
+			}
 			gl_has_errors();
-		} else {
+		}
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, quad.texture);
+		if (quad.effect == EFFECT_ASSET_ID::TEXTURED) {
 			glActiveTexture(GL_TEXTURE1);
-			glBindTexture(GL_TEXTURE_2D, 0);
-			gl_has_errors();
+			glBindTexture(GL_TEXTURE_2D, quad.normal_texture);
 		}
-	}
-	// .obj entities
-	else if (render_request.used_effect == EFFECT_ASSET_ID::MESH)
-	{
-		GLint in_position_loc = glGetAttribLocation(program, "in_position");
-		// GLint in_color_loc = glGetAttribLocation(program, "in_color");
 		gl_has_errors();
 
-		glEnableVertexAttribArray(in_position_loc);
-		glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE,
-							  sizeof(ColoredVertex), (void *)0);
+		perf_stats.count(PERF_COUNTER::DRAW_CALLS);
+		glDrawElements(GL_TRIANGLES, (GLsizei)((last - first) * 6), GL_UNSIGNED_INT, (void*)(first * 6 * sizeof(uint32_t)));
 		gl_has_errors();
+	});
 
-		// glEnableVertexAttribArray(in_color_loc);
-		// glVertexAttribPointer(in_color_loc, 3, GL_FLOAT, GL_FALSE,
-		// 					  sizeof(ColoredVertex), (void *)sizeof(vec3));
-		gl_has_errors();
-	} else {
-		assert(false && "Type of render request not supported");
+	glBindVertexArray(global_vao);
+	sprite_vertices.clear();
+	sprite_quads.clear();
+}
+
+void RenderSystem::bakeStaticLayer(const Map& map, unsigned int map_id)
+{
+	PROFILE_SCOPE("RenderSystem::bakeStaticLayer");
+	static_layer_map_id = map_id;
+
+	// Everything the camera can show, it is clamped to the map (see draw)
+	static_layer_extent = { std::max(map.num_cols * GRID_CELL_WIDTH_PX, WINDOW_WIDTH_PX),
+							std::max(map.num_rows * GRID_CELL_HEIGHT_PX, WINDOW_HEIGHT_PX) };
+
+	// Baked at the resolution the frame is drawn at
+	int w, h;
+	glfwGetFramebufferSize(window, &w, &h);
+	const ivec2 size = ivec2(ceil(static_layer_extent * ((float)w / WINDOW_WIDTH_PX)));
+	if (size != static_layer_size) {
+		initStaticLayerTextures(size);
 	}
 
-	// Getting uniform locations for glUniform* calls
-	GLint color_uloc = glGetUniformLocation(program, "fcolor");
-	const vec4 color = registry.colors.has(entity) ? registry.colors.get(entity) : vec4(1);
-	glUniform4fv(color_uloc, 1, (float *)&color);
+	glBindFramebuffer(GL_FRAMEBUFFER, static_layer_buffer);
+	glViewport(0, 0, size.x, size.y);
+	glClearBufferfv(GL_COLOR, 0, clear_color_value);
+	glClearBufferfv(GL_COLOR, 2, clear_color_value);
+	glClearBufferfv(GL_COLOR, 3, clear_color_value);
+	gl_has_errors();
+
+	// Same layout as createProjectionMatrix, with the whole layer on screen
+	const mat3 projection = {
+		{ 2.f / static_layer_extent.x, 0.f, 0.f },
+		{ 0.f, -2.f / static_layer_extent.y, 0.f },
+		{ -1.f, 1.f, 1.f }
+	};
+
+	for (Entity entity : registry.floors.entities) {
+		if (registry.renderRequests.has(entity)) {
+			drawTexturedMesh(entity, projection);
+		}
+	}
+	flushSprites();
+
+	for (auto [entity, wall, motion, render_request] : registry.view<WallBlock, Motion, RenderRequest>()) {
+		drawTexturedMesh(entity, projection);
+	}
+	// Walls never overlap, so they can be drawn grouped by texture
+	flushSprites(true);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
+	glViewport(0, 0, w, h);
 	gl_has_errors();
+}
+
+void RenderSystem::drawStaticLayer(const mat3& projection)
+{
+	flushSprites();
 
-	// Get number of indices from index buffer, which has elements uint16_t
-	GLint size = 0;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
+	const GLuint used_effect_enum = (GLuint)EFFECT_ASSET_ID::STATIC_LAYER;
+	const EffectLocations& locations = effect_locations[used_effect_enum];
+	glUseProgram(effects[used_effect_enum]);
+	glBindVertexArray(effect_vaos[used_effect_enum][(GLuint)GEOMETRY_BUFFER_ID::SPRITE]);
 	gl_has_errors();
 
-	GLsizei num_indices = size / sizeof(uint16_t);
-	// GLsizei num_triangles = num_indices / 3;
+	// One quad over the whole layer, the fragments off screen are clipped
+	Transform transform;
+	transform.translate(static_layer_extent / 2.f);
+	transform.scale(static_layer_extent);
+	glUniformMatrix3fv(locations.transform, 1, GL_FALSE, (float*)&transform.mat);
+	glUniformMatrix3fv(locations.projection, 1, GL_FALSE, (float*)&projection);
+	gl_has_errors();
 
-	GLint currProgram;
-	glGetIntegerv(GL_CURRENT_PROGRAM, &currProgram);
-	// Setting uniform values to the currently bound program
-	GLuint transform_loc = glGetUniformLocation(currProgram, "transform");
-	glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float *)&transform.mat);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, static_color_texture);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, static_position_texture);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, static_normal_texture);
 	gl_has_errors();
 
-	GLuint projection_loc = glGetUniformLocation(currProgram, "projection");
-	glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float *)&projection);
+	perf_stats.count(PERF_COUNTER::DRAW_CALLS);
+	glDrawElements(GL_TRIANGLES, index_counts[(GLuint)GEOMETRY_BUFFER_ID::SPRITE], GL_UNSIGNED_SHORT, nullptr);
 	gl_has_errors();
 
-	// Drawing of num_indices/3 triangles specified in the index buffer
-	glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, nullptr);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(global_vao);
 	gl_has_errors();
 }
 
@@ -360,6 +412,9 @@ void RenderSystem::drawTexturedMesh(Entity entity, const mat3 &projection, uint8
 // then draw the intermediate texture
 void RenderSystem::drawToScreen(GAME_SCREEN game_screen)
 {
+	PROFILE_SCOPE("RenderSystem::drawToScreen");
+	flushSprites();
+	const EffectLocations& locations = effect_locations[(GLuint)EFFECT_ASSET_ID::POST_PROCESS_LIMITED_VISION];
 	glUseProgram(effects[(GLuint)EFFECT_ASSET_ID::POST_PROCESS_LIMITED_VISION]);
 	gl_has_errors();
 
@@ -378,49 +433,25 @@ void RenderSystem::drawToScreen(GAME_SCREEN game_screen)
 	// glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glDisable(GL_DEPTH_TEST);
 
-	// Draw the screen texture on the quad geometry
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[(GLuint)GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE]);
-	glBindBuffer(
-		GL_ELEMENT_ARRAY_BUFFER,
-		index_buffers[(GLuint)GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE]
-	); 	// Note, GL_ELEMENT_ARRAY_BUFFER associates
-			// indices to the bound GL_ARRAY_BUFFER
+	// Draw the screen texture on the quad geometry, the vao holds its buffers and the position attribute
+	glBindVertexArray(effect_vaos[(GLuint)EFFECT_ASSET_ID::POST_PROCESS_LIMITED_VISION][(GLuint)GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE]);
 	gl_has_errors();
-	
-	const GLuint limited_vision_program = effects[(GLuint)EFFECT_ASSET_ID::POST_PROCESS_LIMITED_VISION];
 
 	// =================================== LIMITED VISION ===================================
 	// Check if player is playing, if so apply limited vision shader
-	GLuint limited_vision_uloc = glGetUniformLocation(limited_vision_program, "limited_vision");
 	Map map;
 	if (registry.maps.components.size() > 0) {
 		map = registry.maps.components[0];
 	}
 	bool limited_vision = map.hasLimitedVision && (game_screen == GAME_SCREEN::PLAYING || game_screen == GAME_SCREEN::TUTORIAL_PLAYING);
-	glUniform1i(limited_vision_uloc, limited_vision);
-	
-	GLuint player_world_position_uloc = glGetUniformLocation(limited_vision_program, "player_world_position");
-	glUniform2f(player_world_position_uloc, player_world_position.x, player_world_position.y);
-	gl_has_errors();
-
-	GLuint player_position_uloc = glGetUniformLocation(limited_vision_program, "player_position");
-	GLuint shadow_color_uloc = glGetUniformLocation(limited_vision_program, "shadow_color");
-	glUniform2f(player_position_uloc, player_screen_position.x, player_screen_position.y);
-	glUniform3f(shadow_color_uloc, map.shadowColor.r, map.shadowColor.g, map.shadowColor.b);
+	glUniform1i(locations.limited_vision, limited_vision);
+	glUniform2f(locations.player_world_position, player_world_position.x, player_world_position.y);
+	glUniform2f(locations.player_position, player_screen_position.x, player_screen_position.y);
+	glUniform3f(locations.shadow_color, map.shadowColor.r, map.shadowColor.g, map.shadowColor.b);
 	gl_has_errors();
 	// ======================================================================================
 
-	// Set the vertex position and vertex texture coordinates
-	GLint in_position_loc = glGetAttribLocation(limited_vision_program, "in_position");
-	gl_has_errors();	
-	
-	glEnableVertexAttribArray(in_position_loc);
-	gl_has_errors();
-	
-	glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void *)0);
-	gl_has_errors();
-	
-	// Bind our texture in Texture Unit 0
+	// Bind our textures to the units the samplers were set to in initializeGlEffects
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, screen_color_texture);
 	gl_has_errors();
@@ -445,22 +476,8 @@ void RenderSystem::drawToScreen(GAME_SCREEN game_screen)
 	glBindTexture(GL_TEXTURE_2D, screen_normal_texture);
 	gl_has_errors();
 
-	
-	GLint screen_color_texture_uloc = glGetUniformLocation(limited_vision_program, "screen_color_texture");
-	GLint limited_vision_object_texture_uloc = glGetUniformLocation(limited_vision_program, "limited_vision_object_texture");
-	// GLint screen_object_id_uloc = glGetUniformLocation(limited_vision_program, "screen_object_id_texture");
-	GLint screen_fire_radius_uloc = glGetUniformLocation(limited_vision_program, "screen_fire_radius_texture");
-	GLint screen_position_uloc = glGetUniformLocation(limited_vision_program, "screen_position_texture");
-	GLint screen_normal_uloc = glGetUniformLocation(limited_vision_program, "screen_normal_texture");
-	glUniform1i(screen_color_texture_uloc, 0);
-	glUniform1i(limited_vision_object_texture_uloc, 1);
-	// glUniform1i(screen_object_id_uloc, 2);
-	glUniform1i(screen_fire_radius_uloc, 2);
-	glUniform1i(screen_position_uloc, 3);
-	glUniform1i(screen_normal_uloc,4);
-	gl_has_errors();
-
 	// Draw
+	perf_stats.count(PERF_COUNTER::DRAW_CALLS);
 	glDrawElements(
 		GL_TRIANGLES, 3, GL_UNSIGNED_SHORT,
 		nullptr); // one triangle = 3 vertices; nullptr indicates that there is
@@ -483,12 +500,66 @@ void RenderSystem::drawToScreen(GAME_SCREEN game_screen)
 	glActiveTexture(GL_TEXTURE4);
 	glBindTexture(GL_TEXTURE_2D, 0);
 	gl_has_errors();
+
+	glBindVertexArray(global_vao);
+}
+
+void RenderSystem::snapshotMotions()
+{
+	ComponentContainer<Motion>& motions = registry.motions;
+	for (uint i = 0; i < motions.size(); i++) {
+		Entity e = motions.entities[i];
+		if (e.index() >= motion_snapshots.size())
+			motion_snapshots.resize(e.index() + 1, { 0, vec2(0) });
+		motion_snapshots[e.index()] = { e.id(), motions.components[i].position };
+	}
+}
+
+void RenderSystem::interpolateMotions(float interpolation)
+{
+	simulated_positions.clear();
+	if (interpolation >= 1.f)
+		return;
+
+	ComponentContainer<Motion>& motions = registry.motions;
+	for (uint i = 0; i < motions.size(); i++) {
+		Entity e = motions.entities[i];
+		// Motions created during the last tick have no snapshot yet
+		if (e.index() >= motion_snapshots.size() || motion_snapshots[e.index()].id != e.id())
+			continue;
+		Motion& motion = motions.components[i];
+		vec2 previous = motion_snapshots[e.index()].position;
+		if (previous == motion.position)
+			continue;
+		// Jumps such as respawns are drawn where they end up
+		vec2 moved = abs(motion.position - previous);
+		if (moved.x > GRID_CELL_WIDTH_PX || moved.y > GRID_CELL_HEIGHT_PX)
+			continue;
+
+		simulated_positions.push_back({ e, motion.position });
+		motion.position = mix(previous, motion.position, interpolation);
+	}
+}
+
+void RenderSystem::restoreMotions()
+{
+	for (std::pair<Entity, vec2>& simulated : simulated_positions) {
+		Motion* motion = registry.motions.try_get(simulated.first);
+		if (motion != nullptr)
+			motion->position = simulated.second;
+	}
+	simulated_positions.clear();
 }
 
 // Render our game world
 // http://www.opengl-tutorial.org/intermediate-tutorials/tutorial-14-render-to-texture/
-void RenderSystem::draw(GAME_SCREEN game_screen)
+void RenderSystem::draw(GAME_SCREEN game_screen, float interpolation)
 {
+	PROFILE_SYSTEM_SCOPE("RenderSystem::draw", PERF_SYSTEM::RENDER);
+
+	// Draw the motions between the last two simulation ticks, the simulated positions are restored at the end
+	interpolateMotions(interpolation);
+
 	// std::cout << "RenderSystem::draw()" <<std::endl;
 	// Getting size of window
 	int w, h;
@@ -565,6 +636,8 @@ void RenderSystem::draw(GAME_SCREEN game_screen)
 
 	// Check if screen is PLAYING and no popups need to be rendered
 	if (game_screen == GAME_SCREEN::PLAYING || game_screen == GAME_SCREEN::TUTORIAL_PLAYING) {
+		PROFILE_SCOPE("RenderSystem world pass");
+
 		// Set the position and normal buffers to overwrite prior values as they are written to
 		glBlendFunci(2, GL_ONE, GL_ZERO);
 		glBlendFunci(3, GL_ONE, GL_ZERO);
@@ -592,30 +665,17 @@ void RenderSystem::draw(GAME_SCREEN game_screen)
 									  -player_screen_position.y/(float)WINDOW_HEIGHT_PX+0.5f };
 		player_world_position = player_motion.position;
 
-		// Draw floor texture for current level
-		for (Entity entity : registry.floors.entities) {
-			if (registry.renderRequests.has(entity)) {
-				drawTexturedMesh(entity, projection_2D);
-			}
+		// Floor and walls, baked once per level with the blending set up above
+		if (map_entity.id() != static_layer_map_id) {
+			bakeStaticLayer(map, map_entity.id());
 		}
+		drawStaticLayer(projection_2D);
 
         float half_width = WINDOW_WIDTH_PX / 2.f;
         float half_height = WINDOW_HEIGHT_PX / 2.f;
         vec2 world_min = cam_pos - vec2(half_width, half_height);
         vec2 world_max = cam_pos + vec2(half_width, half_height);
 
-		// Draw all wallblocks
-		for (Entity entity : registry.wallBlocks.entities) {
-			if (registry.motions.has(entity) && registry.renderRequests.has(entity)) {
-                Motion& motion = registry.motions.get(entity);
-                vec2 half_scale = motion.scale / 2.f;
-                vec min_pos = motion.position - half_scale;
-                vec2 max_pos = motion.position + half_scale;
-                if (max_pos.x < world_min.x || min_pos.x > world_max.x || max_pos.y < world_min.y || min_pos.y > world_max.y) continue;
-				drawTexturedMesh(entity, projection_2D);
-			}
-		}
-
 		// Render to limited vision framebuffer
 		glBindFramebuffer(GL_FRAMEBUFFER, limited_vision_object_buffer);
 
@@ -630,20 +690,17 @@ void RenderSystem::draw(GAME_SCREEN game_screen)
 			if (registry.motions.has(entity) && registry.renderRequests.has(entity)) {
                 Motion& motion = registry.motions.get(entity);
                 vec2 half_scale = motion.scale / 2.f;
-                vec min_pos = motion.position - half_scale;
+                vec2 min_pos = motion.position - half_scale;
                 vec2 max_pos = motion.position + half_scale;
                 if (max_pos.x < world_min.x || min_pos.x > world_max.x || max_pos.y < world_min.y || min_pos.y > world_max.y) continue;
-                
-				if (registry.stages.has(entity)) {
-					Stage& stage = registry.stages.get(entity);
-					if (stage.value == game_state.cur_stage) {
-						drawTexturedMesh(entity, projection_2D);
-					}
-				} else {
+
+				Stage* stage = registry.stages.try_get(entity);
+				if (stage == nullptr || stage->value == game_state.cur_stage) {
 					drawTexturedMesh(entity, projection_2D);
 				}
 			}
 		}
+		flushSprites(true);
 		
 		// Draw all powerups
 		for (Entity entity : registry.powerups.entities) {
@@ -657,7 +714,7 @@ void RenderSystem::draw(GAME_SCREEN game_screen)
 			if (registry.motions.has(entity) && registry.renderRequests.has(entity)) {
                 Motion& motion = registry.motions.get(entity);
                 vec2 half_scale = motion.scale / 2.f;
-                vec min_pos = motion.position - half_scale;
+                vec2 min_pos = motion.position - half_scale;
                 vec2 max_pos = motion.position + half_scale;
                 if (max_pos.x < world_min.x || min_pos.x > world_max.x || max_pos.y < world_min.y || min_pos.y > world_max.y) continue;
 
@@ -673,13 +730,15 @@ void RenderSystem::draw(GAME_SCREEN game_screen)
 			if (registry.motions.has(entity) && registry.renderRequests.has(entity)) {
                 Motion& motion = registry.motions.get(entity);
                 vec2 half_scale = motion.scale / 2.f;
-                vec min_pos = motion.position - half_scale;
+                vec2 min_pos = motion.position - half_scale;
                 vec2 max_pos = motion.position + half_scale;
                 if (max_pos.x < world_min.x || min_pos.x > world_max.x || max_pos.y < world_min.y || min_pos.y > world_max.y) continue;
 				drawTexturedMesh(entity, projection_2D, 5);
 			}
 		}
 
+		flushSprites();
+
 		// Clear fire lighting buffer
 		glClearBufferfv(GL_COLOR, 2, clear_color_value);
 		// Additive blending so that fire on top of any entity additively blends with it
@@ -692,13 +751,15 @@ void RenderSystem::draw(GAME_SCREEN game_screen)
 			if (registry.motions.has(entity) && registry.renderRequests.has(entity)) {
                 Motion& motion = registry.motions.get(entity);
                 vec2 half_scale = motion.scale / 2.f;
-                vec min_pos = motion.position - half_scale;
+                vec2 min_pos = motion.position - half_scale;
                 vec2 max_pos = motion.position + half_scale;
                 if (max_pos.x < world_min.x || min_pos.x > world_max.x || max_pos.y < world_min.y || min_pos.y > world_max.y) continue;
-                
+
 				drawTexturedMesh(entity, projection_2D, 1);
 			}
 		}
+		// Fire is blended additively, its draw order does not matter
+		flushSprites(true);
 
 		// Draw all players
 		for (Entity entity : registry.players.entities) {
@@ -707,12 +768,16 @@ void RenderSystem::draw(GAME_SCREEN game_screen)
 			}
 		}
 
+		flushSprites();
+
 		// Set blend function to this for correct blending between smoke and default framebuffer
 		glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 		
 		// Handle all instances
 		for (InstanceRequest &instance_request : registry.instanceRequests.components)
 		{
+			if (instance_request.items.empty()) continue;
+
             // Update instance buffer data with new transforms
             updateInstanceDataVBO(instance_request.texture, instance_request.items);
 
@@ -771,6 +836,7 @@ void RenderSystem::draw(GAME_SCREEN game_screen)
     }
 
 	// Render all text requests on current screen
+	flushSprites();
 	font_renderer.use(WINDOW_WIDTH_PX, WINDOW_HEIGHT_PX);
 	for (Entity e : registry.textRenderRequests.entities)	{
         if (registry.screens.has(e)) {
@@ -793,6 +859,7 @@ void RenderSystem::draw(GAME_SCREEN game_screen)
                     drawTexturedMesh(e, screen_projection_2D);
                 } else if (registry.textRenderRequests.has(e)) {
                     TextRenderRequest& text = registry.textRenderRequests.get(e);
+                    flushSprites();
                     font_renderer.render(text);
                 }
             }
@@ -802,8 +869,12 @@ void RenderSystem::draw(GAME_SCREEN game_screen)
 	// draw framebuffer to screen
 	// adding "vignette" effect when applied
 	// drawToScreen();
+	flushSprites();
+
+	restoreMotions();
 
 	// flicker-free display with a double buffer
+	PROFILE_SCOPE("RenderSystem swap buffers");
 	glfwSwapBuffers(window);
 	gl_has_errors();
 }
@@ -9,6 +9,8 @@
 #include "tinyECS/tiny_ecs.hpp"
 #include "utils/debug_log.hpp"
 #include "fonts/fonts.hpp"
+#include "mesh_library.hpp"
+#include "utils/sprite_batch.hpp"
 
 // System responsible for setting up OpenGL and for rendering all the
 // visual entities in the game
@@ -20,15 +22,20 @@ class RenderSystem {
 	 * Whenever possible, add to these lists instead of creating dynamic state
 	 * it is easier to debug and faster to execute for the computer.
 	 */
+	// Texture to bind for each asset, an atlas page shared with other assets or a texture of its own
 	std::array<GLuint, texture_count> texture_gl_handles;
 	std::array<ivec2, texture_count>  texture_dimensions;
+	// Where each asset is in its texture, xy is the uv offset and zw the uv size
+	std::array<vec4, texture_count>   texture_uv_rects;
+	// Owns the gl textures texture_gl_handles point to
+	std::vector<GLuint> texture_pages;
+
+	// Assets up to this size in both dimensions are packed into atlas pages
+	static constexpr int ATLAS_PAGE_SIZE = 1024;
+	static constexpr int ATLAS_MAX_ASSET_SIZE = 256;
 	
 	FontRenderer font_renderer;
 
-	// necessary for render function initializeglmeshes but idk what to do with chicken
-	const std::vector<std::pair<GEOMETRY_BUFFER_ID, std::string>> mesh_paths = {
-		std::pair<GEOMETRY_BUFFER_ID, std::string>(GEOMETRY_BUFFER_ID::STAR, mesh_path("star.obj"))
-	};
 
 	// Make sure these paths remain in sync with the associated enumerators (see TEXTURE_ASSET_ID).
 	const std::array<std::string, texture_count> texture_paths = {
@@ -181,18 +188,67 @@ class RenderSystem {
         shader_path("fire"),
         shader_path("mesh"),
         shader_path("font"),
-		shader_path("limited_vision")
+		shader_path("limited_vision"),
+		shader_path("static_layer")
+	};
+
+	// Uniform and attribute locations of an effect, looked up once after linking (-1 if the effect has none)
+	struct EffectLocations {
+		GLint transform = -1;
+		GLint projection = -1;
+		GLint fcolor = -1;
+		GLint time = -1;
+		GLint uv_rect = -1;
+		GLint in_position = -1;
+		GLint in_color = -1;
+		// POST_PROCESS_LIMITED_VISION only
+		GLint limited_vision = -1;
+		GLint player_world_position = -1;
+		GLint player_position = -1;
+		GLint shadow_color = -1;
 	};
+	std::array<EffectLocations, effect_count> effect_locations;
+	// Vertex arrays with the attributes already set up for each effect and geometry pair drawn outside the
+	// sprite batch, 0 for pairs that are never drawn
+	std::array<std::array<GLuint, geometry_count>, effect_count> effect_vaos = {};
+
 	std::array<GLuint, geometry_count> vertex_buffers;
 	std::array<GLuint, geometry_count> index_buffers;
-	std::array<Mesh, geometry_count> meshes;
+	std::array<GLsizei, geometry_count> index_counts = {};
+	MeshLibrary meshes;
 	
 	// global vao to avoid errors
 	GLuint global_vao;
 	
-	// instance variables
-	std::array<GLuint, texture_count> instance_vaos; // Keeps track of the vbo
-	std::array<GLuint, texture_count> instance_vbos; // Holds the instance offset data
+	// instance variables, created the first time a texture is instanced (0 until then)
+	std::array<GLuint, texture_count> instance_vaos = {}; // Keeps track of the vbo
+	std::array<GLuint, texture_count> instance_vbos = {}; // Holds the instance offset data
+	std::array<size_t, texture_count> instance_capacities = {}; // InstancedVertex slots allocated in each vbo
+	std::vector<InstancedVertex> instance_upload;
+
+	// Sprite batching: TEXTURED, POWERUP and FIRE sprites are queued as quads already transformed on the cpu,
+	// and drawn with one draw call per run of quads sharing effect and textures (see queueSprite, flushSprites)
+	struct SpriteVertex {
+		vec3 position;
+		vec2 texcoord;
+		vec3 color;			// geometry vertex color, used by POWERUP
+		vec4 fcolor;
+		float param;		// normal strength for TEXTURED, light radius scale for FIRE
+		GLuint object_id;
+		vec4 uv_rect;		// of the texture in its atlas page
+		vec4 normal_uv_rect;
+	};
+	using SpriteQuad = SpriteBatchKey<GLuint>;	// normal_texture is 0 if no normal map is bound
+	std::array<TexturedVertex, 4> sprite_geometry;	// cpu copy of the SPRITE geometry
+	std::vector<SpriteVertex> sprite_vertices;		// 4 per queued quad
+	std::vector<SpriteQuad> sprite_quads;
+	std::vector<uint32_t> sprite_order;
+	std::vector<SpriteVertex> sprite_upload;
+	mat3 sprite_projection;
+	GLuint sprite_vao = 0;
+	GLuint sprite_vbo = 0;
+	GLuint sprite_ibo = 0;
+	size_t sprite_buffer_quads = 0;	// quads the sprite vbo and ibo have room for
 
 public:
 	// Initialize the window
@@ -201,7 +257,7 @@ public:
 	template <class T>
 	void bindVBOandIBO(GEOMETRY_BUFFER_ID gid, std::vector<T> vertices, std::vector<uint16_t> indices);
 	
-	// Instance helperss
+	// Instance helpers, the buffers of a texture are created by its first updateInstanceDataVBO
 	void initInstanceDataVBO(TEXTURE_ASSET_ID tid);
 	void initInstanceAttribs(TEXTURE_ASSET_ID tid, GEOMETRY_BUFFER_ID gid);
 	
@@ -211,24 +267,32 @@ public:
 	void initializeGlTextures();
 
 	void initializeGlEffects();
+	// Needs the effects and the geometry buffers
+	void initializeGlEffectVaos();
 
 	void initializeGlMeshes();
 
-	Mesh& getMesh(GEOMETRY_BUFFER_ID id) { return meshes[(int)id]; };
+	MeshLibrary& getMeshes() { return meshes; }
+	Mesh& getMesh(GEOMETRY_BUFFER_ID id) { return meshes.get(id); };
 
 	void initializeGlGeometryBuffers();
-	void initializeGLInstanceBuffers();
+	void initializeGlSpriteBatch();
 
 	// Initialize the screen texture used as intermediate render target
 	// The draw loop first renders to this texture, then it is used for the vignette shader
 	bool initScreenTexture();
 	bool initLimitedVisionObjectTexture();
+	// (Re)creates the static layer targets at the given size in pixels
+	void initStaticLayerTextures(ivec2 size);
 
 	// Destroy resources associated to one or all entities created by the system
 	~RenderSystem();
 
-	// Draw all entities
-	void draw(GAME_SCREEN game_screen);
+	// Records where every motion is before a simulation tick
+	void snapshotMotions();
+
+	// Draw all entities, motions are drawn at the given fraction of the way from their snapshot to their current position
+	void draw(GAME_SCREEN game_screen, float interpolation = 1.f);
 
 	mat3 createProjectionMatrix();
 	mat3 createProjectionMatrix(vec2 position);
@@ -242,8 +306,30 @@ private:
 	void drawTexturedInstance(const mat3 &projection, const InstanceRequest &instance_request);
 	void drawToScreen(GAME_SCREEN game_screen);
 
-	// Window handle
-	GLFWwindow* window;
+	// Sprites go through the batch, drawTexturedMesh queues them
+	void queueSprite(Entity entity, const mat3& projection, uint8_t object_id);
+	// Draws the queued sprites, needed before any gl state they depend on changes.
+	// any_order lets quads be grouped by texture first, only for passes whose result does not depend on draw order.
+	void flushSprites(bool any_order = false);
+
+	void createEffectVao(EFFECT_ASSET_ID effect, GEOMETRY_BUFFER_ID geometry);
+
+	// Static level layer: the floor and the walls never change within a level, so they are drawn once into these
+	// targets when a level is loaded and copied into the frame with a single draw afterwards
+	void bakeStaticLayer(const Map& map, unsigned int map_id);
+	void drawStaticLayer(const mat3& projection);
+	GLuint static_layer_buffer = 0;
+	GLuint static_color_texture = 0;
+	GLuint static_position_texture = 0;
+	GLuint static_normal_texture = 0;
+	ivec2 static_layer_size = { 0, 0 };		// in pixels
+	vec2 static_layer_extent = { 0, 0 };	// in world units, the layer starts at the world origin
+	unsigned int static_layer_map_id = 0;	// id of the map entity the layer was baked for, 0 if none
+
+	void destroyGlResources();
+
+	// Window handle, null until init (and in headless runs)
+	GLFWwindow* window = nullptr;
 
 	// Buffer to render objects affected by limited vision
 	GLuint limited_vision_object_buffer;
@@ -270,6 +356,17 @@ private:
 	GLfloat clear_color_value[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
 	// GLfloat clear_float_value[1] = { 0.0f };
 
+	// Motion positions before the latest simulation tick, indexed by entity index
+	struct MotionSnapshot {
+		unsigned int id;
+		vec2 position;
+	};
+	std::vector<MotionSnapshot> motion_snapshots;
+	// Simulated positions of the motions moved for drawing, put back after the frame
+	std::vector<std::pair<Entity, vec2>> simulated_positions;
+	void interpolateMotions(float interpolation);
+	void restoreMotions();
+
 	Entity screen_state_entity;
 	vec2 player_world_position;
 	vec2 player_screen_position;
@@ -1,6 +1,7 @@
 // stdlib
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 #include <array>
 #include <fstream>
 
@@ -8,6 +9,7 @@
 #include "../ext/stb_image/stb_image.h"
 #include "render_system.hpp"
 #include "tinyECS/registry.hpp"
+#include "utils/atlas_packer.hpp"
 
 
 // Render initialization
@@ -16,7 +18,6 @@ bool RenderSystem::init(GLFWwindow* window_arg)
 	this->window = window_arg;
 
 	glfwMakeContextCurrent(window);
-	glfwSwapInterval(1); // vsync
 
 	// Load OpenGL function pointers
 	const int is_fine = gl3w_init();
@@ -63,10 +64,10 @@ bool RenderSystem::init(GLFWwindow* window_arg)
 	initializeGlTextures();
 	initializeGlEffects();
 	initializeGlGeometryBuffers();
+	initializeGlEffectVaos();
+	initializeGlSpriteBatch();
 
 	font_renderer.init(effects[(int)EFFECT_ASSET_ID::FONT]);
-	
-	initializeGLInstanceBuffers();
 
     // Change window icon to chilli pepper
     GLFWimage images[1];
@@ -87,40 +88,73 @@ bool RenderSystem::init(GLFWwindow* window_arg)
 
 void RenderSystem::initializeGlTextures()
 {
-	glGenTextures((GLsizei)texture_gl_handles.size(), texture_gl_handles.data());
+	std::array<stbi_uc*, texture_count> images;
+	std::vector<AtlasPacker::Size> atlas_sizes;
+	std::vector<uint> atlas_assets;
 
 	for(uint i = 0; i < texture_paths.size(); i++)
 	{
 		const std::string& path = texture_paths[i];
 		ivec2& dimensions = texture_dimensions[i];
 
-		stbi_uc* data;
-		data = stbi_load(path.c_str(), &dimensions.x, &dimensions.y, NULL, 4);
+		images[i] = stbi_load(path.c_str(), &dimensions.x, &dimensions.y, NULL, 4);
 
-		if (data == NULL)
+		if (images[i] == NULL)
 		{
 			const std::string message = "Could not load the file " + path + ".";
 			fprintf(stderr, "%s", message.c_str());
 			assert(false);
 		}
-		glBindTexture(GL_TEXTURE_2D, texture_gl_handles[i]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, dimensions.x, dimensions.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		if (i >= (uint)TEXTURE_ASSET_ID::FIRE_1 && i <= (uint)TEXTURE_ASSET_ID::FIRE_14) {
-			// Potentially use mipmaps for bloom
-			// glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
-			// glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			// glGenerateMipmap(GL_TEXTURE_2D);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-		} else {
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		// Sprites go into the atlas, big images (floors, stories, recipes) keep a texture of their own
+		if (dimensions.x <= ATLAS_MAX_ASSET_SIZE && dimensions.y <= ATLAS_MAX_ASSET_SIZE) {
+			atlas_sizes.push_back({ dimensions.x, dimensions.y });
+			atlas_assets.push_back(i);
 		}
+	}
+
+	auto create_texture = [this](int width, int height, const void* data) {
+		GLuint texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 		gl_has_errors();
-		stbi_image_free(data);
+		texture_pages.push_back(texture);
+		return texture;
+	};
+
+	AtlasPacker packer(ATLAS_PAGE_SIZE);
+	const std::vector<AtlasPacker::Placement> placements = packer.pack(atlas_sizes);
+	std::vector<std::vector<stbi_uc>> page_pixels(packer.page_count(), std::vector<stbi_uc>((size_t)ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE * 4, 0));
+	for (size_t k = 0; k < atlas_assets.size(); k++) {
+		const uint i = atlas_assets[k];
+		const AtlasPacker::Placement& placement = placements[k];
+		packer.blit(page_pixels[placement.page].data(), images[i], texture_dimensions[i].x, texture_dimensions[i].y, placement);
+		texture_uv_rects[i] = vec4(placement.x, placement.y, texture_dimensions[i].x, texture_dimensions[i].y) / (float)ATLAS_PAGE_SIZE;
+	}
+	std::vector<GLuint> pages;
+	for (const std::vector<stbi_uc>& pixels : page_pixels) {
+		pages.push_back(create_texture(ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, pixels.data()));
+	}
+	for (size_t k = 0; k < atlas_assets.size(); k++) {
+		texture_gl_handles[atlas_assets[k]] = pages[placements[k].page];
+	}
+
+	size_t next_atlas_asset = 0;
+	for (uint i = 0; i < texture_paths.size(); i++) {
+		if (next_atlas_asset < atlas_assets.size() && atlas_assets[next_atlas_asset] == i) {
+			next_atlas_asset++;
+		} else {
+			texture_gl_handles[i] = create_texture(texture_dimensions[i].x, texture_dimensions[i].y, images[i]);
+			texture_uv_rects[i] = vec4(0.f, 0.f, 1.f, 1.f);
+		}
+		stbi_image_free(images[i]);
 	}
+	DEBUG_LOG << "Packed " << atlas_assets.size() << " textures into " << pages.size() << " atlas pages, "
+			  << texture_paths.size() - atlas_assets.size() << " textures left on their own";
 	gl_has_errors();
 }
 
@@ -133,7 +167,88 @@ void RenderSystem::initializeGlEffects()
 
 		bool is_valid = loadEffectFromFile(vertex_shader_name, fragment_shader_name, effects[i]);
 		assert(is_valid && (GLuint)effects[i] != 0);
+
+		const GLuint program = effects[i];
+		EffectLocations& locations = effect_locations[i];
+		locations.transform = glGetUniformLocation(program, "transform");
+		locations.projection = glGetUniformLocation(program, "projection");
+		locations.fcolor = glGetUniformLocation(program, "fcolor");
+		locations.time = glGetUniformLocation(program, "time");
+		locations.uv_rect = glGetUniformLocation(program, "uv_rect");
+		locations.in_position = glGetAttribLocation(program, "in_position");
+		locations.in_color = glGetAttribLocation(program, "in_color");
+		locations.limited_vision = glGetUniformLocation(program, "limited_vision");
+		locations.player_world_position = glGetUniformLocation(program, "player_world_position");
+		locations.player_position = glGetUniformLocation(program, "player_position");
+		locations.shadow_color = glGetUniformLocation(program, "shadow_color");
+		gl_has_errors();
 	}
+
+	// Texture units never change, so the samplers are set once
+	const GLuint textured_program = effects[(GLuint)EFFECT_ASSET_ID::TEXTURED];
+	glUseProgram(textured_program);
+	glUniform1i(glGetUniformLocation(textured_program, "color_sampler"), 0);
+	glUniform1i(glGetUniformLocation(textured_program, "normal_sampler"), 1);
+
+	const GLuint limited_vision_program = effects[(GLuint)EFFECT_ASSET_ID::POST_PROCESS_LIMITED_VISION];
+	glUseProgram(limited_vision_program);
+	glUniform1i(glGetUniformLocation(limited_vision_program, "screen_color_texture"), 0);
+	glUniform1i(glGetUniformLocation(limited_vision_program, "limited_vision_object_texture"), 1);
+	glUniform1i(glGetUniformLocation(limited_vision_program, "screen_fire_radius_texture"), 2);
+	glUniform1i(glGetUniformLocation(limited_vision_program, "screen_position_texture"), 3);
+	glUniform1i(glGetUniformLocation(limited_vision_program, "screen_normal_texture"), 4);
+
+	const GLuint static_layer_program = effects[(GLuint)EFFECT_ASSET_ID::STATIC_LAYER];
+	glUseProgram(static_layer_program);
+	glUniform1i(glGetUniformLocation(static_layer_program, "static_color"), 0);
+	glUniform1i(glGetUniformLocation(static_layer_program, "static_position"), 1);
+	glUniform1i(glGetUniformLocation(static_layer_program, "static_normal"), 2);
+	glUseProgram(0);
+	gl_has_errors();
+}
+
+void RenderSystem::createEffectVao(EFFECT_ASSET_ID effect, GEOMETRY_BUFFER_ID geometry)
+{
+	const EffectLocations& locations = effect_locations[(GLuint)effect];
+	GLuint& vao = effect_vaos[(GLuint)effect][(GLuint)geometry];
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[(GLuint)geometry]);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffers[(GLuint)geometry]);
+	gl_has_errors();
+
+	// The screen triangle is bare positions, the sprite is TexturedVertex, the box and the meshes are ColoredVertex
+	if (geometry == GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE) {
+		glEnableVertexAttribArray(locations.in_position);
+		glVertexAttribPointer(locations.in_position, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void*)0);
+	} else if (geometry == GEOMETRY_BUFFER_ID::SPRITE) {
+		glEnableVertexAttribArray(locations.in_position);
+		glVertexAttribPointer(locations.in_position, 3, GL_FLOAT, GL_FALSE,
+			sizeof(TexturedVertex), (void*)offsetof(TexturedVertex, position));
+	} else {
+		glEnableVertexAttribArray(locations.in_position);
+		glVertexAttribPointer(locations.in_position, 3, GL_FLOAT, GL_FALSE,
+			sizeof(ColoredVertex), (void*)offsetof(ColoredVertex, position));
+		// Unused colors get compiled out of the shader
+		if (locations.in_color >= 0) {
+			glEnableVertexAttribArray(locations.in_color);
+			glVertexAttribPointer(locations.in_color, 3, GL_FLOAT, GL_FALSE,
+				sizeof(ColoredVertex), (void*)offsetof(ColoredVertex, color));
+		}
+	}
+	gl_has_errors();
+
+	glBindVertexArray(global_vao);
+}
+
+void RenderSystem::initializeGlEffectVaos()
+{
+	createEffectVao(EFFECT_ASSET_ID::BOX, GEOMETRY_BUFFER_ID::BOX);
+	for (const std::pair<GEOMETRY_BUFFER_ID, std::string>& mesh_path : meshes.mesh_paths) {
+		createEffectVao(EFFECT_ASSET_ID::MESH, mesh_path.first);
+	}
+	createEffectVao(EFFECT_ASSET_ID::POST_PROCESS_LIMITED_VISION, GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE);
+	createEffectVao(EFFECT_ASSET_ID::STATIC_LAYER, GEOMETRY_BUFFER_ID::SPRITE);
 }
 
 void RenderSystem::initInstanceAttribs(TEXTURE_ASSET_ID tid, GEOMETRY_BUFFER_ID gid)
@@ -224,43 +339,16 @@ void RenderSystem::initInstanceAttribs(TEXTURE_ASSET_ID tid, GEOMETRY_BUFFER_ID
 }
 
 
-void RenderSystem::initInstanceDataVBO(TEXTURE_ASSET_ID tid) 
-{	
-	// bind to the instance's VAO
-	glBindVertexArray(instance_vaos[(uint)tid]);
-	
-	// Create Instance VBO (Keeps track of the instance offset data)
+void RenderSystem::initInstanceDataVBO(TEXTURE_ASSET_ID tid)
+{
+	// Create the instance VAO and VBO (keeps track of the instance offset data)
+	// The VBO gets its storage on upload, sized to the instances actually drawn
+	glGenVertexArrays(1, &instance_vaos[(uint)tid]);
 	glGenBuffers(1, &instance_vbos[(uint)tid]);
-	
-	// Bind to the VBO (handles the individual instance values)
-	glBindBuffer(GL_ARRAY_BUFFER, instance_vbos[(uint)tid]);
-	
-	// Load dummy instance data to the instance's VBO to initialize size
-	std::vector<InstancedVertex> instances(MAX_PARTICLES + 500); 
-	size_t buffer_size = instances.size() * sizeof(InstancedVertex);
-	glBufferData(GL_ARRAY_BUFFER, buffer_size, instances.data(), GL_DYNAMIC_DRAW);
-	
-	// Unbind to avoid accidental augmentations
-	glBindBuffer(GL_ARRAY_BUFFER, 0); 
-	
+	instance_capacities[(uint)tid] = 0;
 	gl_has_errors();
-	
-	// Rebind to global VAO to avoid accidental augmentations
-	glBindVertexArray(global_vao);
-}
 
-void RenderSystem::initializeGLInstanceBuffers() 
-{	
-	// Create Instance VAO (keeps track of entirety of instance data)
-	glGenVertexArrays((GLsizei)instance_vaos.size(), instance_vaos.data());
-	
-	for (int i = 0; i < texture_count; i++) 
-	{
-		initInstanceDataVBO((TEXTURE_ASSET_ID)i);
-		
-		initInstanceAttribs((TEXTURE_ASSET_ID)i, GEOMETRY_BUFFER_ID::SPRITE);
-		
-	}
+	initInstanceAttribs(tid, GEOMETRY_BUFFER_ID::SPRITE);
 }
 
 // One could merge the following two functions as a template function...
@@ -281,23 +369,19 @@ void RenderSystem::bindVBOandIBO(GEOMETRY_BUFFER_ID gid, std::vector<T> vertices
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
 		sizeof(indices[0]) * indices.size(), indices.data(), GL_STATIC_DRAW);
 	gl_has_errors();
+	index_counts[(uint)gid] = (GLsizei)indices.size();
 }
 
 void RenderSystem::initializeGlMeshes()
 {
-	for (uint i = 0; i < mesh_paths.size(); i++)
+	meshes.load();
+	for (uint i = 0; i < meshes.mesh_paths.size(); i++)
 	{
 		// Initialize meshes
-		GEOMETRY_BUFFER_ID geom_index = mesh_paths[i].first;
-		std::string name = mesh_paths[i].second;
-		Mesh::loadFromOBJFile(name, 
-			meshes[(int)geom_index].vertices,
-			meshes[(int)geom_index].vertex_indices,
-			meshes[(int)geom_index].original_size);
-
+		GEOMETRY_BUFFER_ID geom_index = meshes.mesh_paths[i].first;
 		bindVBOandIBO(geom_index,
-			meshes[(int)geom_index].vertices, 
-			meshes[(int)geom_index].vertex_indices);
+			meshes.get(geom_index).vertices, 
+			meshes.get(geom_index).vertex_indices);
 	}
 }
 
@@ -331,6 +415,7 @@ void RenderSystem::initializeGlGeometryBuffers()
 	// Counterclockwise as it's the default OpenGL front winding direction.
 	const std::vector<uint16_t> textured_indices = { 0, 3, 1, 1, 3, 2 };
 	bindVBOandIBO(GEOMETRY_BUFFER_ID::SPRITE, textured_vertices, textured_indices);
+	std::copy(textured_vertices.begin(), textured_vertices.end(), sprite_geometry.begin());
 
 	//////////////////////////////////
 	// Initialize debug line
@@ -352,9 +437,8 @@ void RenderSystem::initializeGlGeometryBuffers()
 	// Two triangles
 	line_indices = {0, 1, 3, 1, 2, 3};
 	
-	int geom_index = (int)GEOMETRY_BUFFER_ID::BOX;
-	meshes[geom_index].vertices = line_vertices;
-	meshes[geom_index].vertex_indices = line_indices;
+	meshes.get(GEOMETRY_BUFFER_ID::BOX).vertices = line_vertices;
+	meshes.get(GEOMETRY_BUFFER_ID::BOX).vertex_indices = line_indices;
 	bindVBOandIBO(GEOMETRY_BUFFER_ID::BOX, line_vertices, line_indices);
 
 	///////////////////////////////////////////////////////
@@ -369,13 +453,68 @@ void RenderSystem::initializeGlGeometryBuffers()
 	bindVBOandIBO(GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE, screen_vertices, screen_indices);
 }
 
+void RenderSystem::initializeGlSpriteBatch()
+{
+	glGenVertexArrays(1, &sprite_vao);
+	glGenBuffers(1, &sprite_vbo);
+	glGenBuffers(1, &sprite_ibo);
+
+	// The sprite shaders share attribute locations, so one vao serves all of them
+	glBindVertexArray(sprite_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, sprite_vbo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sprite_ibo);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, texcoord));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, color));
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, fcolor));
+	glEnableVertexAttribArray(4);
+	glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, param));
+	glEnableVertexAttribArray(5);
+	glVertexAttribIPointer(5, 1, GL_UNSIGNED_INT, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, object_id));
+	glEnableVertexAttribArray(6);
+	glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, uv_rect));
+	glEnableVertexAttribArray(7);
+	glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)offsetof(SpriteVertex, normal_uv_rect));
+	gl_has_errors();
+
+	glBindVertexArray(global_vao);
+}
+
 RenderSystem::~RenderSystem()
+{
+	// Headless runs never created any gl resources
+	if (window != nullptr) {
+		destroyGlResources();
+	}
+
+	// remove all entities created by the render system
+	while (registry.renderRequests.entities.size() > 0)
+			registry.remove_all_components_of(registry.renderRequests.entities.back());
+}
+
+void RenderSystem::destroyGlResources()
 {
 	// Don't need to free gl resources since they last for as long as the program,
 	// but it's polite to clean after yourself.
 	glDeleteBuffers((GLsizei)vertex_buffers.size(), vertex_buffers.data());
 	glDeleteBuffers((GLsizei)index_buffers.size(), index_buffers.data());
-	glDeleteTextures((GLsizei)texture_gl_handles.size(), texture_gl_handles.data());
+	glDeleteBuffers(1, &sprite_vbo);
+	glDeleteBuffers(1, &sprite_ibo);
+	glDeleteVertexArrays(1, &sprite_vao);
+	// Textures never instanced have 0 names, which are ignored
+	glDeleteBuffers((GLsizei)instance_vbos.size(), instance_vbos.data());
+	glDeleteVertexArrays((GLsizei)instance_vaos.size(), instance_vaos.data());
+	for (std::array<GLuint, geometry_count>& vaos : effect_vaos) {
+		for (GLuint vao : vaos) {
+			if (vao != 0) glDeleteVertexArrays(1, &vao);
+		}
+	}
+	glDeleteTextures((GLsizei)texture_pages.size(), texture_pages.data());
 	glDeleteTextures(1, &screen_fire_radius_texture);
 	glDeleteTextures(1, &screen_object_id_texture);
 	glDeleteTextures(1, &limited_vision_object_color_texture);
@@ -391,11 +530,11 @@ RenderSystem::~RenderSystem()
 	// delete allocated resources
 	glDeleteFramebuffers(1, &limited_vision_object_buffer);
 	glDeleteFramebuffers(1, &frame_buffer);
+	glDeleteTextures(1, &static_color_texture);
+	glDeleteTextures(1, &static_position_texture);
+	glDeleteTextures(1, &static_normal_texture);
+	glDeleteFramebuffers(1, &static_layer_buffer);
 	gl_has_errors();
-
-	// remove all entities created by the render system
-	while (registry.renderRequests.entities.size() > 0)
-			registry.remove_all_components_of(registry.renderRequests.entities.back());
 }
 
 // Initialize the screen texture from a standard sprite
@@ -461,6 +600,46 @@ bool RenderSystem::initScreenTexture()
 	return true;
 }
 
+void RenderSystem::initStaticLayerTextures(ivec2 size)
+{
+	if (static_layer_buffer == 0) {
+		glGenFramebuffers(1, &static_layer_buffer);
+		glGenTextures(1, &static_color_texture);
+		glGenTextures(1, &static_position_texture);
+		glGenTextures(1, &static_normal_texture);
+	}
+	static_layer_size = size;
+	glBindFramebuffer(GL_FRAMEBUFFER, static_layer_buffer);
+
+	// Same formats as the frame_buffer targets the layer is copied into
+	glBindTexture(GL_TEXTURE_2D, static_color_texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, static_color_texture, 0);
+	gl_has_errors();
+
+	glBindTexture(GL_TEXTURE_2D, static_position_texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, size.x, size.y, 0, GL_RGB, GL_FLOAT, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, static_position_texture, 0);
+	gl_has_errors();
+
+	glBindTexture(GL_TEXTURE_2D, static_normal_texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, size.x, size.y, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, static_normal_texture, 0);
+	gl_has_errors();
+
+	// The floor and walls never write an object id, the slot stays unbound so the attachments line up with the shaders
+	GLenum drawBuffers[4] = { GL_COLOR_ATTACHMENT0, GL_NONE, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
+	glDrawBuffers(4, drawBuffers);
+
+	assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+}
+
 bool RenderSystem::initLimitedVisionObjectTexture()
 {
 	int framebuffer_width, framebuffer_height;
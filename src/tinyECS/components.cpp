@@ -5,6 +5,7 @@
 #include "../ext/stb_image/stb_image.h"
 
 // stlib
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -119,3 +120,50 @@ bool Mesh::loadFromOBJFile(std::string obj_path, std::vector<ColoredVertex>& out
 
 	return true;
 }
+
+// Triangles per BVH leaf
+const unsigned int MESH_BVH_LEAF_SIZE = 2;
+
+void Mesh::buildCollisionBVH()
+{
+	assert(vertex_indices.size() % 3 == 0 && "ERROR: Non-triangle mesh passed!");
+	collision_triangles.clear();
+	collision_bvh.clear();
+	for (size_t a = 2; a < vertex_indices.size(); a += 3) {
+		collision_triangles.push_back({
+			vec2(vertices[vertex_indices[a-2]].position),
+			vec2(vertices[vertex_indices[a-1]].position),
+			vec2(vertices[vertex_indices[a]].position) });
+	}
+	if (collision_triangles.empty())
+		return;
+
+	// Top-down build, splitting each node at the median triangle centroid along its longer axis
+	collision_bvh.push_back({ vec2(0), vec2(0), 0, (unsigned int)collision_triangles.size() });
+	for (size_t n = 0; n < collision_bvh.size(); n++) {
+		unsigned int first = collision_bvh[n].first;
+		unsigned int count = collision_bvh[n].count;
+		auto begin = collision_triangles.begin() + first;
+		auto end = begin + count;
+
+		vec2 min_pos = begin->a, max_pos = begin->a;
+		for (auto t = begin; t != end; t++) {
+			min_pos = glm::min(min_pos, glm::min(t->a, glm::min(t->b, t->c)));
+			max_pos = glm::max(max_pos, glm::max(t->a, glm::max(t->b, t->c)));
+		}
+		collision_bvh[n].min = min_pos;
+		collision_bvh[n].max = max_pos;
+		if (count <= MESH_BVH_LEAF_SIZE)
+			continue;
+
+		int axis = (max_pos.x - min_pos.x >= max_pos.y - min_pos.y) ? 0 : 1;
+		std::nth_element(begin, begin + count / 2, end, [axis](const MeshTriangle& t1, const MeshTriangle& t2) {
+			return (t1.a + t1.b + t1.c)[axis] < (t2.a + t2.b + t2.c)[axis];
+		});
+		unsigned int children = (unsigned int)collision_bvh.size();
+		collision_bvh.push_back({ vec2(0), vec2(0), first, count / 2 });
+		collision_bvh.push_back({ vec2(0), vec2(0), first + count / 2, count - count / 2 });
+		collision_bvh[n].first = children;
+		collision_bvh[n].count = 0;
+	}
+}
@@ -230,6 +230,12 @@ struct WallBlock {
 
 };
 
+// Level geometry that never moves once placed (walls, borders, the floor).
+// Physics keeps these in a precomputed per-cell structure and per-frame loops skip them.
+struct StaticBody {
+
+};
+
 // Powerup component
 struct Powerup {
 	PowerType type;
@@ -249,6 +255,19 @@ struct Obstacle {
 	// to cross them. however maybe for rendering it will help. TBD.
 };
 
+// What an entity collides as, PhysicsSystem decides which pairs of layers are tested against each other
+enum class COLLISION_LAYER {
+	DEFAULT = 0,	// collides with every layer
+	OBSTACLE,		// walls, fire has its own layer
+	FIRE,
+	PLAYER,
+	ENEMY,
+	INGREDIENT,
+	POWERUP,
+	COLLISION_LAYER_COUNT
+};
+const int collision_layer_count = (int)COLLISION_LAYER::COLLISION_LAYER_COUNT;
+
 // All data relevant to the shape and motion of entities
 struct Motion {
 	vec2  position 			= { 0, 0 };
@@ -258,6 +277,7 @@ struct Motion {
 	vec2  scale    			= { 10, 10 };	 // visual scale
 	vec2  hitbox			= { 10, 10 };	 // scale of hitbox
 	bool collidable = false;					// whether this object has physics collisions
+	COLLISION_LAYER collision_layer = COLLISION_LAYER::DEFAULT;
 };
 
 // Stucture to store collision information
@@ -265,7 +285,7 @@ struct Collision
 {
 	// Note, the first object is stored in the ECS container.entities
 	Entity other; // the second object involved in the collision
-	Collision(Entity& other) { this->other = other; };
+	Collision(Entity& other) : other(other) {}; // copy directly so no fresh id is allocated for a default Entity
 };
 
 // Data structure for toggling debug mode
@@ -325,6 +345,21 @@ struct InstancedVertex
 	}
 };
 
+// Triangle of a mesh collider, in mesh-local xy coordinates
+struct MeshTriangle
+{
+	vec2 a, b, c;
+};
+
+// Node of the bounding volume hierarchy over the collision triangles of a mesh.
+// A leaf (count > 0) holds collision_triangles[first .. first+count), an inner node has its children at first and first+1.
+struct MeshBVHNode
+{
+	vec2 min, max;
+	unsigned int first;
+	unsigned int count;
+};
+
 // Mesh datastructure for storing vertex and index buffers
 struct Mesh
 {
@@ -332,6 +367,11 @@ struct Mesh
 	vec2 original_size = {1,1};
 	std::vector<ColoredVertex> vertices;
 	std::vector<uint16_t> vertex_indices;
+
+	// Collision data in mesh-local space, ignoring the z axis. Built once when the mesh is loaded.
+	std::vector<MeshTriangle> collision_triangles;
+	std::vector<MeshBVHNode> collision_bvh;	// root at index 0, empty if the mesh has no triangles
+	void buildCollisionBVH();
 };
 
 /**
@@ -610,6 +650,7 @@ enum class EFFECT_ASSET_ID {
     MESH,
     FONT,
 	POST_PROCESS_LIMITED_VISION,
+	STATIC_LAYER,
 	EFFECT_COUNT,
 };
 const int effect_count = (int)EFFECT_ASSET_ID::EFFECT_COUNT;
@@ -1,17 +1,46 @@
 #pragma once
 
+#include <deque>
+#include <vector>
+#include <assert.h>
+#include <stddef.h>
+
 // Unique identifier for all entities
+// The id packs a slot index (low bits) with a generation counter (high bits). Released indices are
+// recycled through a FIFO free list, and the generation is bumped on release so that stale copies of a
+// destroyed entity never compare equal to the new entity that reuses its index. An index is only reused
+// once MIN_FREE_INDICES others were released after it, so a generation wraps after
+// (GENERATION_MASK + 1) * MIN_FREE_INDICES releases at the earliest, not after 4096 create/destroy pairs.
 class Entity
 {
+public:
+    static constexpr unsigned int INDEX_BITS = 18;
+    static constexpr unsigned int INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr unsigned int GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+    static constexpr size_t MIN_FREE_INDICES = 1024;
+
+private:
     unsigned int m_id;
-    static unsigned int id_count;   // defaults to 0 (invalid), need to init 1
+    static unsigned int id_count;   // next never-used index, defaults to 0 (invalid), need to init 1
+    static std::vector<unsigned int> generations;   // current generation of each index
+    static std::deque<unsigned int> free_indices;   // released indices, oldest first
 
 public:
 
     Entity()
     {
-        // ensure that each entity gets a unique ID
-        m_id = id_count++; // assign and increment
+        // ensure that each entity gets a unique ID, reusing the oldest released index once enough are queued
+        unsigned int index;
+        if (free_indices.size() > MIN_FREE_INDICES) {
+            index = free_indices.front();
+            free_indices.pop_front();
+        } else {
+            index = id_count++; // assign and increment
+            assert(index <= INDEX_MASK && "Too many live entities");
+            if (generations.size() <= index)
+                generations.resize(index + 1, 0);
+        }
+        m_id = index | (generations[index] << INDEX_BITS);
     }
 
     /*
@@ -25,7 +54,26 @@ public:
     {
     }
 
-    operator unsigned int() { return m_id; } // enables automatic casting to int
+    operator unsigned int() const { return m_id; } // enables automatic casting to int
+
+    unsigned int id() const { return m_id; }
+
+    unsigned int index() const { return m_id & INDEX_MASK; }
 
-    unsigned int id() { return m_id; }
-};
\ No newline at end of file
+    unsigned int generation() const { return m_id >> INDEX_BITS; }
+
+    // Is this handle still referring to a live entity (i.e., has it not been released)?
+    bool is_alive() const { return index() < generations.size() && generations[index()] == generation(); }
+
+    // Number of entity handles currently allocated (not yet released)
+    static unsigned int live_count() { return id_count - 1 - (unsigned int)free_indices.size(); }
+
+    // Recycle the index of e; every existing copy of e becomes stale
+    static void release(Entity e)
+    {
+        if (!e.is_alive())
+            return;
+        generations[e.index()] = (generations[e.index()] + 1) & GENERATION_MASK;
+        free_indices.push_back(e.index());
+    }
+};
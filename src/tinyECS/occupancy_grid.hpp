@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include "entity.hpp"
+
+// What occupies a grid cell, a cell holds at most one entity per layer
+enum class GRID_LAYER {
+	OBSTACLE = 0,	// walls, fire has its own layer
+	FIRE,
+	INGREDIENT,
+	ENEMY,
+	PLAYER,
+	POWERUP,
+	GRID_LAYER_COUNT
+};
+const int grid_layer_count = (int)GRID_LAYER::GRID_LAYER_COUNT;
+
+constexpr uint8_t grid_layer_bit(GRID_LAYER layer) {
+	return (uint8_t)(1u << (int)layer);
+}
+
+// Layers that block movement (fire blocks are obstacles too)
+constexpr uint8_t BLOCKING_GRID_LAYERS = grid_layer_bit(GRID_LAYER::OBSTACLE) | grid_layer_bit(GRID_LAYER::FIRE);
+
+// Dense row-major occupancy grid of the current map, indexed by (x, y) grid coordinates.
+// Queries only read the packed layer bits, the per-layer entity slots are looked at when an entity is asked for.
+// Cells outside the map read as obstacles.
+class OccupancyGrid
+{
+	using Slots = std::array<std::optional<Entity>, grid_layer_count>;
+
+	int num_rows = 0;
+	int num_cols = 0;
+	// Cells whose BLOCKING_GRID_LAYERS bits changed, blocking_log[i] is change number blocking_log_start + i
+	std::vector<int> blocking_log;
+	unsigned int blocking_log_start = 0;
+	static constexpr size_t BLOCKING_LOG_CAPACITY = 4096;
+	std::vector<uint8_t> layer_bits;	// one bit per GRID_LAYER for each cell
+	std::vector<Slots> slots;
+
+	// Reverse index, the (cell, layer) keys each entity occupies, indexed by entity index
+	std::vector<std::vector<unsigned int>> keys_of_entity;
+
+	int cell_index(std::pair<int, int> cell) const {
+		if (cell.first < 0 || cell.second < 0 || cell.first >= num_cols || cell.second >= num_rows)
+			return -1;
+		return cell.second * num_cols + cell.first;
+	}
+
+	void log_blocking_change(int i) {
+		if (blocking_log.size() >= BLOCKING_LOG_CAPACITY) {
+			blocking_log_start += (unsigned int)blocking_log.size();
+			blocking_log.clear();
+		}
+		blocking_log.push_back(i);
+	}
+
+	void forget_key(Entity e, unsigned int key) {
+		std::vector<unsigned int>& keys = keys_of_entity[e.index()];
+		keys.erase(std::remove(keys.begin(), keys.end(), key), keys.end());
+	}
+
+public:
+	// Resizes the grid to the map dimensions, emptying every cell
+	void resize(int rows, int cols) {
+		// Skip a version so that every consumer sees a gap in the log and starts over
+		blocking_log_start = blocking_version() + 1;
+		blocking_log.clear();
+		num_rows = rows;
+		num_cols = cols;
+		layer_bits.assign((size_t)rows * cols, 0);
+		slots.assign((size_t)rows * cols, Slots());
+		for (std::vector<unsigned int>& keys : keys_of_entity)
+			keys.clear();
+	}
+
+	void clear() {
+		resize(num_rows, num_cols);
+	}
+
+	int rows() const { return num_rows; }
+	int cols() const { return num_cols; }
+
+	// Changes whenever an obstacle or fire cell is added or removed, lets cached path data detect staleness
+	unsigned int blocking_version() const { return blocking_log_start + (unsigned int)blocking_log.size(); }
+
+	// Appends the cells whose blocking layers changed since the given version.
+	// Returns false if the log no longer reaches back that far (or the grid was resized), the caller has to start over.
+	bool blocking_changes_since(unsigned int version, std::vector<std::pair<int, int>>& cells) const {
+		if (version < blocking_log_start || version > blocking_version())
+			return false;
+		for (size_t k = version - blocking_log_start; k < blocking_log.size(); k++)
+			cells.push_back({ blocking_log[k] % num_cols, blocking_log[k] / num_cols });
+		return true;
+	}
+
+	// All layer bits of a cell
+	uint8_t layers(std::pair<int, int> cell) const {
+		int i = cell_index(cell);
+		return i < 0 ? grid_layer_bit(GRID_LAYER::OBSTACLE) : layer_bits[i];
+	}
+
+	// Does the cell have any of the layers in mask
+	bool any(std::pair<int, int> cell, uint8_t mask) const {
+		return (layers(cell) & mask) != 0;
+	}
+
+	bool has(std::pair<int, int> cell, GRID_LAYER layer) const {
+		return any(cell, grid_layer_bit(layer));
+	}
+
+	std::optional<Entity> get(std::pair<int, int> cell, GRID_LAYER layer) const {
+		int i = cell_index(cell);
+		if (i < 0)
+			return std::nullopt;
+		return slots[i][(int)layer];
+	}
+
+	// Places e on a layer of the cell, replacing the previous occupant of that layer
+	void set(std::pair<int, int> cell, GRID_LAYER layer, Entity e) {
+		int i = cell_index(cell);
+		if (i < 0)
+			return;
+		unset(cell, layer);
+
+		unsigned int key = (unsigned int)i * grid_layer_count + (int)layer;
+		if (grid_layer_bit(layer) & BLOCKING_GRID_LAYERS)
+			log_blocking_change(i);
+		layer_bits[i] |= grid_layer_bit(layer);
+		slots[i][(int)layer] = e;
+		if (e.index() >= keys_of_entity.size())
+			keys_of_entity.resize(e.index() + 1);
+		keys_of_entity[e.index()].push_back(key);
+	}
+
+	// Empties a layer of the cell
+	void unset(std::pair<int, int> cell, GRID_LAYER layer) {
+		int i = cell_index(cell);
+		if (i < 0 || !(layer_bits[i] & grid_layer_bit(layer)))
+			return;
+		forget_key(slots[i][(int)layer].value(), (unsigned int)i * grid_layer_count + (int)layer);
+		if (grid_layer_bit(layer) & BLOCKING_GRID_LAYERS)
+			log_blocking_change(i);
+		layer_bits[i] &= ~grid_layer_bit(layer);
+		slots[i][(int)layer].reset();
+	}
+
+	// Empties a layer of the cell only if e is what occupies it
+	void unset(std::pair<int, int> cell, GRID_LAYER layer, Entity e) {
+		std::optional<Entity> occupant = get(cell, layer);
+		if (occupant.has_value() && occupant.value().id() == e.id())
+			unset(cell, layer);
+	}
+
+	// Removes e from every cell it occupies
+	void remove(Entity e) {
+		if (e.index() >= keys_of_entity.size())
+			return;
+		std::vector<unsigned int>& keys = keys_of_entity[e.index()];
+		for (size_t k = 0; k < keys.size();) {
+			unsigned int i = keys[k] / grid_layer_count;
+			int layer = keys[k] % grid_layer_count;
+			// A stale handle leaves the cells of the entity now using its index alone
+			if (slots[i][layer].value().id() != e.id()) {
+				k++;
+				continue;
+			}
+			if ((1u << layer) & BLOCKING_GRID_LAYERS)
+				log_blocking_change((int)i);
+			layer_bits[i] &= ~(uint8_t)(1u << layer);
+			slots[i][layer].reset();
+			keys[k] = keys.back();
+			keys.pop_back();
+		}
+	}
+};
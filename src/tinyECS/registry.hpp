@@ -1,33 +1,21 @@
 #pragma once
+#include <functional>
 #include <optional>
 #include <vector>
 
 #include "tiny_ecs.hpp"
+#include "occupancy_grid.hpp"
 #include "components.hpp"
 
-// From https://medium.com/@gulshansharma014/call-to-implicitly-deleted-default-constructor-of-unordered-map-pair-int-int-int-d3b2a6da0b41
-// Hash function for pair
-struct pair_hash {
-    template <class T1, class T2>
-    std::size_t operator() (const std::pair<T1, T2>& p) const {
-        auto h1 = std::hash<T1>{}(p.first);
-        auto h2 = std::hash<T2>{}(p.second);
-        return h1 ^ h2;
-    }
-};
-// Function to evaluate equality of two pairs
-struct pair_equal {
-    template <class T1, class T2>
-    bool operator() (const std::pair<T1, T2>& lhs, const std::pair<T1, T2>& rhs) const {
-        return lhs.first == rhs.first && lhs.second == rhs.second;
-    }
-};
-
 class ECSRegistry
 {
 	// callbacks to remove a particular or all entities in the system
 	std::vector<ContainerInterface*> registry_list;
 
+	// Structural changes recorded while systems iterate the containers, applied by flush_commands()
+	std::vector<std::function<void()>> deferred_commands;
+	std::vector<Entity> deferred_destroys;
+
 public:
 	// Manually created list of all components this game has
 	ComponentContainer<Motion> motions;
@@ -50,6 +38,7 @@ public:
 	// IMPORTANT: Add any new CC's below to the registry_list
     ComponentContainer<Box> boxes;
     ComponentContainer<WallBlock> wallBlocks;
+    ComponentContainer<StaticBody> staticBodies;
     ComponentContainer<ParticleSpawner> particleSpawners;
 	ComponentContainer<Particle> particles;
 	ComponentContainer<InstanceRequest> instanceRequests;
@@ -65,8 +54,11 @@ public:
     ComponentContainer<Hud> hud;
     ComponentContainer<Popup> popups;
 
-	// Maps grid coordinates to entities
-	std::unordered_map<std::pair<int, int>, std::optional<Entity>, pair_hash, pair_equal> map_grid_coord_entityID;
+	// Which entities occupy each grid cell of the current map
+	OccupancyGrid grid;
+
+	// Component signature of every entity (one bit per container in registry_list), indexed by entity index
+	std::vector<uint64_t> component_signatures;
 
 	// constructor that adds all containers for looping over them
 	ECSRegistry()
@@ -90,6 +82,7 @@ public:
 		registry_list.push_back(&colors);
 		registry_list.push_back(&boxes);
         registry_list.push_back(&wallBlocks);
+        registry_list.push_back(&staticBodies);
         registry_list.push_back(&instanceRequests);
 		registry_list.push_back(&particles);
         registry_list.push_back(&animationStates);
@@ -105,6 +98,13 @@ public:
         registry_list.push_back(&game_state);
         registry_list.push_back(&hud);
         registry_list.push_back(&popups);
+
+		// Each container owns one bit of the entity signatures
+		assert(registry_list.size() <= 64 && "Component signatures only hold 64 containers");
+		for (unsigned int i = 0; i < registry_list.size(); i++) {
+			registry_list[i]->signatures = &component_signatures;
+			registry_list[i]->signature_bit = i;
+		}
 	}
 
 	void clear_all_components() {
@@ -127,22 +127,132 @@ public:
 	}
 
 	void remove_all_components_of(Entity e) {
-		remove_from_grid_entity_map(e);
+		grid.remove(e);
 
-		for (ContainerInterface* reg : registry_list)
-			reg->remove(e);
+		// Only visit the containers the entity has components in
+		unsigned int id = e.index();
+		if (id >= component_signatures.size())
+			return;
+		uint64_t signature = component_signatures[id];
+		for (unsigned int bit = 0; signature != 0; bit++, signature >>= 1) {
+			if (signature & 1)
+				registry_list[bit]->remove(e);
+		}
+	}
+
+	// Removes all components of e and recycles its id, use for entities that are never reused afterwards
+	// (fire, smoke, particles, level entities...). Any remaining copies of e become stale.
+	void destroy_entity(Entity e) {
+		remove_all_components_of(e);
+		Entity::release(e);
 	}
 
-	void remove_from_grid_entity_map(Entity e) {
-		// Remove entity from grid-entity map
-		for (auto it = map_grid_coord_entityID.begin(); it != map_grid_coord_entityID.end(); ++it) {
-			if (it->second.has_value() && it->second.value().id() == e.id()) { map_grid_coord_entityID.erase(it); break; }
+	// Records a create (e.g. a createFireBlock call) or any other structural change to run at the next flush
+	void defer(std::function<void()> command) {
+		deferred_commands.push_back(std::move(command));
+	}
+
+	// Records adding component c to e at the next flush
+	template <typename Component>
+	void defer_emplace(ComponentContainer<Component>& container, Entity e, Component c) {
+		defer([&container, e, c = std::move(c)]() mutable { container.insert(e, std::move(c)); });
+	}
+
+	// Records destroy_entity(e) to run at the next flush
+	void defer_destroy(Entity e) {
+		deferred_destroys.push_back(e);
+	}
+
+	// Sync point: runs the recorded commands in order, then destroys all recorded entities in one batch,
+	// touching only the containers that hold a component of a destroyed entity
+	void flush_commands() {
+		// Commands may record further commands, which run in the same flush
+		for (size_t i = 0; i < deferred_commands.size(); i++) {
+			std::function<void()> command = std::move(deferred_commands[i]);
+			command();
+		}
+		deferred_commands.clear();
+
+		if (deferred_destroys.empty())
+			return;
+
+		uint64_t touched = 0;
+		for (Entity e : deferred_destroys) {
+			grid.remove(e);
+			if (e.index() < component_signatures.size())
+				touched |= component_signatures[e.index()];
+		}
+		for (unsigned int bit = 0; touched != 0; bit++, touched >>= 1) {
+			if (touched & 1)
+				registry_list[bit]->remove_batch(deferred_destroys);
 		}
+		// release() ignores handles that are already stale, so duplicates are fine
+		for (Entity e : deferred_destroys)
+			Entity::release(e);
+		deferred_destroys.clear();
 	}
 
-	void clear_grid_entity_map() {
-		map_grid_coord_entityID.clear();
+	// Drops all recorded changes, used when the level they were recorded against is torn down
+	void discard_commands() {
+		deferred_commands.clear();
+		deferred_destroys.clear();
+	}
+
+	// Container holding components of type Component, see the specializations below.
+	// RenderRequest maps to renderRequests, highlightBlocks has to be viewed explicitly
+	template <typename Component>
+	ComponentContainer<Component>& container();
+
+	// Multi-component query, e.g. for (auto [entity, motion, render_request, enemy] : registry.view<Motion, RenderRequest, Enemy>())
+	template <typename... Components>
+	ComponentView<Components...> view() {
+		return ComponentView<Components...>(container<Components>()...);
+	}
+
+	// Grid layer the entity occupies, GRID_LAYER_COUNT if it is not tracked on the grid
+	GRID_LAYER grid_layer_of(Entity e) {
+		if (fireBlocks.has(e)) return GRID_LAYER::FIRE;
+		if (obstacles.has(e)) return GRID_LAYER::OBSTACLE;
+		if (players.has(e)) return GRID_LAYER::PLAYER;
+		if (enemies.has(e)) return GRID_LAYER::ENEMY;
+		if (ingredients.has(e)) return GRID_LAYER::INGREDIENT;
+		if (powerups.has(e)) return GRID_LAYER::POWERUP;
+		return GRID_LAYER::GRID_LAYER_COUNT;
 	}
 };
 
+// Type -> container mapping used by ECSRegistry::view
+template <> inline ComponentContainer<Motion>& ECSRegistry::container<Motion>() { return motions; }
+template <> inline ComponentContainer<Collision>& ECSRegistry::container<Collision>() { return collisions; }
+template <> inline ComponentContainer<Player>& ECSRegistry::container<Player>() { return players; }
+template <> inline ComponentContainer<Enemy>& ECSRegistry::container<Enemy>() { return enemies; }
+template <> inline ComponentContainer<Ingredient>& ECSRegistry::container<Ingredient>() { return ingredients; }
+template <> inline ComponentContainer<FireBlock>& ECSRegistry::container<FireBlock>() { return fireBlocks; }
+template <> inline ComponentContainer<SmokeBlock>& ECSRegistry::container<SmokeBlock>() { return smokeBlocks; }
+template <> inline ComponentContainer<Powerup>& ECSRegistry::container<Powerup>() { return powerups; }
+template <> inline ComponentContainer<Timer>& ECSRegistry::container<Timer>() { return timers; }
+template <> inline ComponentContainer<Obstacle>& ECSRegistry::container<Obstacle>() { return obstacles; }
+template <> inline ComponentContainer<MeshCollider>& ECSRegistry::container<MeshCollider>() { return meshColliders; }
+template <> inline ComponentContainer<Mesh*>& ECSRegistry::container<Mesh*>() { return meshPtrs; }
+template <> inline ComponentContainer<RenderRequest>& ECSRegistry::container<RenderRequest>() { return renderRequests; }
+template <> inline ComponentContainer<ScreenState>& ECSRegistry::container<ScreenState>() { return screenStates; }
+template <> inline ComponentContainer<DebugComponent>& ECSRegistry::container<DebugComponent>() { return debugComponents; }
+template <> inline ComponentContainer<vec4>& ECSRegistry::container<vec4>() { return colors; }
+template <> inline ComponentContainer<Box>& ECSRegistry::container<Box>() { return boxes; }
+template <> inline ComponentContainer<WallBlock>& ECSRegistry::container<WallBlock>() { return wallBlocks; }
+template <> inline ComponentContainer<StaticBody>& ECSRegistry::container<StaticBody>() { return staticBodies; }
+template <> inline ComponentContainer<ParticleSpawner>& ECSRegistry::container<ParticleSpawner>() { return particleSpawners; }
+template <> inline ComponentContainer<Particle>& ECSRegistry::container<Particle>() { return particles; }
+template <> inline ComponentContainer<InstanceRequest>& ECSRegistry::container<InstanceRequest>() { return instanceRequests; }
+template <> inline ComponentContainer<AnimationState>& ECSRegistry::container<AnimationState>() { return animationStates; }
+template <> inline ComponentContainer<Map>& ECSRegistry::container<Map>() { return maps; }
+template <> inline ComponentContainer<Stage>& ECSRegistry::container<Stage>() { return stages; }
+template <> inline ComponentContainer<Floor>& ECSRegistry::container<Floor>() { return floors; }
+template <> inline ComponentContainer<TextRenderRequest>& ECSRegistry::container<TextRenderRequest>() { return textRenderRequests; }
+template <> inline ComponentContainer<PathFinding>& ECSRegistry::container<PathFinding>() { return pathfindings; }
+template <> inline ComponentContainer<GameScreen>& ECSRegistry::container<GameScreen>() { return screens; }
+template <> inline ComponentContainer<GameState>& ECSRegistry::container<GameState>() { return game_state; }
+template <> inline ComponentContainer<Hud>& ECSRegistry::container<Hud>() { return hud; }
+template <> inline ComponentContainer<Popup>& ECSRegistry::container<Popup>() { return popups; }
+
 extern ECSRegistry registry;
\ No newline at end of file
@@ -1,12 +1,17 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <memory>
+#include <tuple>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 #include <set>
 #include <functional>
 #include <typeindex>
 #include <assert.h>
+#include <stdint.h>
 #include <iostream>
 
 #include "entity.hpp"
@@ -18,6 +23,12 @@ struct ContainerInterface
 	virtual size_t size() = 0;
 	virtual void remove(Entity e) = 0;
 	virtual bool has(Entity entity) = 0;
+	virtual void remove_batch(const std::vector<Entity>& doomed) = 0;
+
+	// Component signatures owned by the registry, indexed by entity index. Bit 'signature_bit' is set while
+	// the entity has a component in this container. Left null for containers that are not registered.
+	std::vector<uint64_t>* signatures = nullptr;
+	unsigned int signature_bit = 0;
 };
 
 // A container that stores components of type 'Component' and associated entities
@@ -25,10 +36,59 @@ template <typename Component> // A component can be any class
 class ComponentContainer : public ContainerInterface
 {
 private:
-	// The hash map from Entity -> array index.
-	std::unordered_map<unsigned int, unsigned int> map_entity_componentID; // the entity is cast to uint to be hashable.
+	// Sparse index from Entity -> array index, split into fixed-size pages that are only allocated
+	// for the id ranges actually in use. A lookup is two array reads instead of a hash probe.
+	static constexpr unsigned int SPARSE_PAGE_SIZE = 1024;
+	using SparsePage = std::array<unsigned int, SPARSE_PAGE_SIZE>;
+	std::vector<std::unique_ptr<SparsePage>> sparse_pages; // keyed by the entity's index, not its full (generational) id.
 	bool registered = false;
+
+	// Scratch for remove_batch, one flag per dense slot, kept to reuse its allocation
+	std::vector<uint8_t> removal_marks;
+
+	// Returns the sparse slot of the given entity, or nullptr if its page was never allocated
+	unsigned int* sparse_slot(Entity e)
+	{
+		unsigned int id = e.index();
+		unsigned int page = id / SPARSE_PAGE_SIZE;
+		if (page >= sparse_pages.size() || !sparse_pages[page])
+			return nullptr;
+		return &(*sparse_pages[page])[id % SPARSE_PAGE_SIZE];
+	}
+
+	// Sets or clears this container's bit in the entity's signature
+	void update_signature(Entity e, bool owned)
+	{
+		if (signatures == nullptr)
+			return;
+		unsigned int id = e.index();
+		if (id >= signatures->size())
+			signatures->resize(id + 1, 0);
+		if (owned)
+			(*signatures)[id] |= (uint64_t)1 << signature_bit;
+		else
+			(*signatures)[id] &= ~((uint64_t)1 << signature_bit);
+	}
+
+	// Returns the sparse slot of the given entity, allocating its page if necessary
+	unsigned int& assure_sparse_slot(Entity e)
+	{
+		unsigned int id = e.index();
+		unsigned int page = id / SPARSE_PAGE_SIZE;
+		if (page >= sparse_pages.size())
+			sparse_pages.resize(page + 1);
+		if (!sparse_pages[page])
+		{
+			sparse_pages[page] = std::make_unique<SparsePage>();
+			sparse_pages[page]->fill(INVALID_INDEX);
+		}
+		return (*sparse_pages[page])[id % SPARSE_PAGE_SIZE];
+	}
+
 public:
+	// Dense position returned by find() for entities without this component
+	static constexpr unsigned int INVALID_INDEX = ~0u;
+
 	// Container of all components of type 'Component'
 	std::vector<Component> components;
 
@@ -46,7 +106,8 @@ public:
 		// Usually, every entity should only have one instance of each component type
 		assert(!(check_for_duplicates && has(e)) && "Entity already contained in ECS registry");
 
-		map_entity_componentID[e] = (unsigned int)components.size();
+		assure_sparse_slot(e) = (unsigned int)components.size();
+		update_signature(e, true);
 		components.push_back(std::move(c)); // the move enforces move instead of copy constructor
 		entities.push_back(e);
 		return components.back();
@@ -70,12 +131,28 @@ public:
 			std::cerr << "Entity not contained in ECS registry for component" << typeid(Component).name() << std::endl;
 			assert(false);
 		}
-		return components[map_entity_componentID[e]];
+		return components[*sparse_slot(e)];
+	}
+
+	// Returns the position of the entity's component in 'components', or INVALID_INDEX if it has none
+	unsigned int find(Entity e) {
+		unsigned int* slot = sparse_slot(e);
+		if (slot == nullptr || *slot == INVALID_INDEX || entities[*slot].id() != e.id())
+			return INVALID_INDEX;
+		return *slot;
+	}
+
+	// Returns the component of an entity, or nullptr if it has none. Does has() and get() in a single lookup
+	Component* try_get(Entity e) {
+		unsigned int slot = find(e);
+		return slot == INVALID_INDEX ? nullptr : &components[slot];
 	}
 
 	// Check if entity has a component of type 'Component'
+	// A stale handle (same index, older generation) is rejected by comparing the stored id
 	bool has(Entity entity) {
-		return map_entity_componentID.count(entity) > 0;
+		unsigned int* slot = sparse_slot(entity);
+		return slot != nullptr && *slot != INVALID_INDEX && entities[*slot].id() == entity.id();
 	}
 
 	// Remove an component and pack the container to re-use the empty space
@@ -84,26 +161,70 @@ public:
 		if (has(e))
 		{
 			// Get the current position
-			int cID = map_entity_componentID[e];
+			unsigned int* slot = sparse_slot(e);
+			unsigned int cID = *slot;
 
 			// Move the last element to position cID using the move operator
 			// Note, components[cID] = components.back() would trigger the copy instead of move operator
 			components[cID] = std::move(components.back());
 			entities[cID] = entities.back(); // the entity is only a single index, copy it.
-			map_entity_componentID[entities.back()] = cID;
+			*sparse_slot(entities.back()) = cID;
 
 			// Erase the old component and free its memory
-			map_entity_componentID.erase(e);
+			*slot = INVALID_INDEX;
 			components.pop_back();
 			entities.pop_back();
+			update_signature(e, false);
 			// Note, one could mark the id for re-use
 		}
 	};
 
+	// Remove the components of all given entities in one pass: the dead slots are marked, then the survivors
+	// after the first one are moved down once and their sparse slots updated. The remaining components keep
+	// their order.
+	void remove_batch(const std::vector<Entity>& doomed)
+	{
+		removal_marks.assign(components.size(), 0);
+		unsigned int first = INVALID_INDEX;
+		for (Entity e : doomed)
+		{
+			unsigned int slot = find(e);
+			if (slot == INVALID_INDEX)
+				continue;
+			removal_marks[slot] = 1;
+			first = std::min(first, slot);
+		}
+		if (first == INVALID_INDEX)
+			return;
+
+		unsigned int kept = first;
+		for (unsigned int cID = first; cID < components.size(); cID++)
+		{
+			Entity e = entities[cID];
+			if (removal_marks[cID])
+			{
+				*sparse_slot(e) = INVALID_INDEX;
+				update_signature(e, false);
+				continue;
+			}
+			components[kept] = std::move(components[cID]);
+			entities[kept] = e;
+			*sparse_slot(e) = kept;
+			kept++;
+		}
+		components.erase(components.begin() + kept, components.end());
+		entities.erase(entities.begin() + kept, entities.end());
+	}
+
 	// Remove all components of type 'Component'
 	void clear()
 	{
-		map_entity_componentID.clear();
+		// Only reset the slots in use, so the allocated pages can be reused
+		for (Entity& e : entities)
+		{
+			*sparse_slot(e) = INVALID_INDEX;
+			update_signature(e, false);
+		}
 		components.clear();
 		entities.clear();
 	}
@@ -122,10 +243,81 @@ public:
 		std::sort(entities.begin(), entities.end(), comparisonFunction);
 		// Now re-arrange the components (Note, creates a new vector, which may be slow! Not sure if in-place could be faster: https://stackoverflow.com/questions/63703637/how-to-efficiently-permute-an-array-in-place-using-stdswap)
 		std::vector<Component> components_new; components_new.reserve(components.size());
-		std::transform(entities.begin(), entities.end(), std::back_inserter(components_new), [&](Entity e) { return std::move(get(e)); }); // note, the get still uses the old hash map (on purpose!)
+		std::transform(entities.begin(), entities.end(), std::back_inserter(components_new), [&](Entity e) { return std::move(get(e)); }); // note, the get still uses the old sparse index (on purpose!)
 		components = std::move(components_new); // note, we use move operations to not create unneccesary copies of objects, but memory is still allocated for the new vector
-		// Fill the new hashmap
+		// Fill the new sparse index
 		for (unsigned int i = 0; i < entities.size(); i++)
-			map_entity_componentID[entities[i]] = i;
+			*sparse_slot(entities[i]) = i;
 	}
 };
+
+// Iterates all entities that have every one of the given components, e.g.
+//     for (auto [entity, motion, enemy] : ComponentView<Motion, Enemy>(registry.motions, registry.enemies)) { ... }
+// Iteration is driven by the smallest container (the first one on ties). Its components are read by dense index and
+// every other component is fetched with a single sparse lookup. Inserting or removing components of the viewed types
+// while iterating is not allowed.
+template <typename... Components>
+class ComponentView
+{
+	static_assert(sizeof...(Components) > 0, "A view needs at least one component type");
+
+	using Containers = std::tuple<ComponentContainer<Components>*...>;
+	Containers containers;
+	std::vector<Entity>* driver = nullptr;
+	size_t driver_slot = 0; // position of the driving container in 'containers'
+
+public:
+	class iterator
+	{
+		Containers containers;
+		std::vector<Entity>* driver;
+		size_t driver_slot;
+		size_t i;
+		std::array<unsigned int, sizeof...(Components)> slots; // dense positions of the current entity's components
+
+		// Looks up the components of the current entity in order, returns false at the first one that is missing.
+		// The driving container holds the entity at position i, so only the others need a sparse lookup.
+		template <size_t... I>
+		bool fetch(std::index_sequence<I...>)
+		{
+			Entity e = (*driver)[i];
+			return ((I == driver_slot ? (slots[I] = (unsigned int)i, true)
+									  : (slots[I] = std::get<I>(containers)->find(e)) != ComponentContainer<Components>::INVALID_INDEX) && ...);
+		}
+
+		template <size_t... I>
+		std::tuple<Entity, Components&...> deref(std::index_sequence<I...>) const
+		{
+			return std::tuple<Entity, Components&...>((*driver)[i], std::get<I>(containers)->components[slots[I]]...);
+		}
+
+	public:
+		iterator(Containers containers, std::vector<Entity>* driver, size_t driver_slot, size_t i)
+			: containers(containers), driver(driver), driver_slot(driver_slot), i(i)
+		{
+		}
+
+		std::tuple<Entity, Components&...> operator*() const { return deref(std::index_sequence_for<Components...>()); }
+
+		// Moves to the next entity that has all components, or to the end. begin() starts one before the first entity
+		iterator& operator++()
+		{
+			size_t n = driver->size();
+			while (++i < n && !fetch(std::index_sequence_for<Components...>()))
+				;
+			return *this;
+		}
+
+		bool operator!=(const iterator& other) const { return i != other.i; }
+		bool operator==(const iterator& other) const { return i == other.i; }
+	};
+
+	ComponentView(ComponentContainer<Components>&... cs) : containers(&cs...)
+	{
+		size_t smallest = SIZE_MAX, slot = 0;
+		((cs.entities.size() < smallest ? (smallest = cs.entities.size(), driver = &cs.entities, driver_slot = slot) : 0, slot++), ...);
+	}
+
+	iterator begin() const { return ++iterator(containers, driver, driver_slot, SIZE_MAX); }
+	iterator end() const { return iterator(containers, driver, driver_slot, driver->size()); }
+};
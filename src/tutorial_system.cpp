@@ -1,5 +1,6 @@
 #include "tutorial_system.hpp"
 #include "world_system.hpp"
+#include "utils/profiler.hpp"
 
 TutorialSystem::TutorialSystem() {
 	// empty
@@ -14,17 +15,15 @@ void TutorialSystem::reset() {
         num_tiles_moved = 0;
         spawned_fire = false;
 		
-		for (Entity e : registry.powerups.entities) {
-			registry.remove_all_components_of(e);
-		}
+		// Destroying shrinks the container, so always take the last entity instead of iterating it
+		while (!registry.powerups.entities.empty())
+			registry.destroy_entity(registry.powerups.entities.back());
 		
-		for (Entity e : registry.enemies.entities) {
-			registry.remove_all_components_of(e);
-		}
+		while (!registry.enemies.entities.empty())
+			registry.destroy_entity(registry.enemies.entities.back());
 		
-		for (Entity e : registry.ingredients.entities) {
-			registry.remove_all_components_of(e);
-		}
+		while (!registry.ingredients.entities.empty())
+			registry.destroy_entity(registry.ingredients.entities.back());
 		
 		clearIngredientsHud();
 		
@@ -33,21 +32,20 @@ void TutorialSystem::reset() {
 }
 
 void TutorialSystem::clearMapEntities() {
-    for (Entity e : registry.powerups.entities) {
-        registry.remove_all_components_of(e);
-    }
+    registry.discard_commands();
+
+    // Destroying shrinks the container, so always take the last entity instead of iterating it
+    while (!registry.powerups.entities.empty())
+        registry.destroy_entity(registry.powerups.entities.back());
     
-    for (Entity e : registry.enemies.entities) {
-        registry.remove_all_components_of(e);
-    }
+    while (!registry.enemies.entities.empty())
+        registry.destroy_entity(registry.enemies.entities.back());
     
-    for (Entity e : registry.ingredients.entities) {
-        registry.remove_all_components_of(e);
-    }
+    while (!registry.ingredients.entities.empty())
+        registry.destroy_entity(registry.ingredients.entities.back());
 
-    for (Entity e : registry.fireBlocks.entities) {
-        registry.remove_all_components_of(e);
-    }
+    while (!registry.fireBlocks.entities.empty())
+        registry.destroy_entity(registry.fireBlocks.entities.back());
 }
 
 void TutorialSystem::init(MapGenerator* _map_generator, PopupWindow& popup_window) 
@@ -123,6 +121,7 @@ ivec2 TutorialSystem::get_nearby_position(int radius, int min_radius) {
 }
 
 void TutorialSystem::step(float elapsed_ms) {
+	PROFILE_SCOPE("TutorialSystem::step");
 	timer -= elapsed_ms;
 	// No need to check every frame (excessive)
 	if (timer < 0) {
@@ -222,8 +221,8 @@ void TutorialSystem::handle_ingredient_penalty(bool reset) {
 					clearMapEntities();
 				}
 			} else {
-				if (registry.ingredients.has(this_entity)) registry.remove_all_components_of(this_entity);
-				if (registry.ingredients.has(other_entity)) registry.remove_all_components_of(other_entity);
+				if (registry.ingredients.has(this_entity)) registry.destroy_entity(this_entity);
+				if (registry.ingredients.has(other_entity)) registry.destroy_entity(other_entity);
 			}
 			
 			return;
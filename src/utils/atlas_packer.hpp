@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <assert.h>
+#include <cstring>
+#include <numeric>
+#include <stdint.h>
+#include <vector>
+
+// Packs images into square atlas pages, shelf by shelf with the tallest images first.
+// Every image keeps a border of PADDING pixels copied from its edge, so nearest sampling right at the edge of
+// its rect never picks up a neighbour.
+class AtlasPacker
+{
+	int page_size;
+	int pages = 0;
+
+public:
+	static constexpr int PADDING = 1;
+
+	struct Size {
+		int width;
+		int height;
+	};
+
+	// Where an image went, x and y are its top left pixel inside the padding
+	struct Placement {
+		int page;
+		int x;
+		int y;
+	};
+
+	explicit AtlasPacker(int page_size) : page_size(page_size) {}
+
+	int page_count() const { return pages; }
+
+	// Places all images at once, the placements are in the order of sizes. Every size must fit a page with its padding.
+	std::vector<Placement> pack(const std::vector<Size>& sizes) {
+		std::vector<size_t> order(sizes.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) { return sizes[a].height > sizes[b].height; });
+
+		std::vector<Placement> placements(sizes.size());
+		int page = 0, x = 0, y = 0, shelf_height = 0;
+		for (size_t i : order) {
+			const int width = sizes[i].width + 2 * PADDING;
+			const int height = sizes[i].height + 2 * PADDING;
+			assert(width <= page_size && height <= page_size);
+			if (x + width > page_size) {
+				// Next shelf
+				y += shelf_height;
+				x = 0;
+				shelf_height = 0;
+			}
+			if (y + height > page_size) {
+				// Next page
+				page++;
+				x = 0;
+				y = 0;
+				shelf_height = 0;
+			}
+			placements[i] = { page, x + PADDING, y + PADDING };
+			x += width;
+			shelf_height = std::max(shelf_height, height);
+		}
+		pages = sizes.empty() ? 0 : page + 1;
+		return placements;
+	}
+
+	// Copies an RGBA image to its placement in an RGBA page, filling the padding with the image's edge pixels
+	void blit(uint8_t* page_pixels, const uint8_t* image, int width, int height, const Placement& placement) const {
+		for (int row = -PADDING; row < height + PADDING; row++) {
+			const int image_row = std::clamp(row, 0, height - 1);
+			for (int col = -PADDING; col < width + PADDING; col++) {
+				const int image_col = std::clamp(col, 0, width - 1);
+				std::memcpy(page_pixels + ((size_t)(placement.y + row) * page_size + placement.x + col) * 4,
+							image + ((size_t)image_row * width + image_col) * 4, 4);
+			}
+		}
+	}
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+// Paces the main loop to a target frame time without pinning a core.
+// Sleeps until shortly before the next frame is due and only spins for the rest, how much earlier it wakes
+// adapts to how late sleeps return on this machine. Also tracks the achieved frame times to report jitter.
+class FramePacer
+{
+	using Clock = std::chrono::steady_clock;
+
+	// The margin stays under a millisecond so that a machine with coarse sleeps does not burn a core spinning,
+	// its frames run a little late instead
+	static constexpr float MIN_SPIN_MARGIN_MS = 0.1f;
+	static constexpr float MAX_SPIN_MARGIN_MS = 0.75f;
+
+	std::chrono::duration<float, std::milli> target_frame = std::chrono::duration<float, std::milli>(0.f);
+	Clock::time_point last_frame;
+	Clock::time_point next_frame;
+	float spin_margin_ms = 0.5f;
+
+	// Frame time statistics of the current report window
+	int frame_count = 0;
+	double frame_ms_sum = 0.0;
+	double frame_ms_sum_sq = 0.0;
+	float worst_frame_ms = 0.f;
+
+	static float to_ms(Clock::duration d) {
+		return std::chrono::duration<float, std::milli>(d).count();
+	}
+
+public:
+	// Statistics of the last finished report window
+	struct Report {
+		int frames = 0;
+		float mean_ms = 0.f;
+		float jitter_ms = 0.f;	// standard deviation of the frame time
+		float worst_ms = 0.f;
+	};
+
+	// A target of 0 does not wait at all, e.g. when vsync already paces the buffer swaps
+	void init(float target_frame_ms) {
+		target_frame = std::chrono::duration<float, std::milli>(target_frame_ms);
+		last_frame = next_frame = Clock::now();
+	}
+
+	// Waits until the next frame is due, returns the time since the previous frame in milliseconds
+	float wait_for_next_frame() {
+		Clock::duration target = std::chrono::duration_cast<Clock::duration>(target_frame);
+		Clock::time_point now = Clock::now();
+		// After a long frame start over from now rather than rushing through the missed frames
+		if (now - next_frame > target)
+			next_frame = now;
+
+		Clock::time_point wake = next_frame - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(spin_margin_ms));
+		if (wake > now) {
+			std::this_thread::sleep_until(wake);
+			float oversleep_ms = to_ms(Clock::now() - wake);
+			spin_margin_ms = std::clamp(std::max(oversleep_ms, spin_margin_ms * 0.99f), MIN_SPIN_MARGIN_MS, MAX_SPIN_MARGIN_MS);
+		}
+		while (Clock::now() < next_frame) {
+			std::this_thread::yield();
+		}
+
+		now = Clock::now();
+		float elapsed_ms = to_ms(now - last_frame);
+		last_frame = now;
+		next_frame += target;
+
+		frame_count++;
+		frame_ms_sum += elapsed_ms;
+		frame_ms_sum_sq += (double)elapsed_ms * elapsed_ms;
+		worst_frame_ms = std::max(worst_frame_ms, elapsed_ms);
+		return elapsed_ms;
+	}
+
+	// Time covered by the current report window in milliseconds
+	float report_window_ms() const { return (float)frame_ms_sum; }
+
+	// Closes the current report window and returns its statistics
+	Report take_report() {
+		Report report;
+		report.frames = frame_count;
+		if (frame_count > 0) {
+			double mean = frame_ms_sum / frame_count;
+			report.mean_ms = (float)mean;
+			report.jitter_ms = (float)std::sqrt(std::max(0.0, frame_ms_sum_sq / frame_count - mean * mean));
+			report.worst_ms = worst_frame_ms;
+		}
+		frame_count = 0;
+		frame_ms_sum = frame_ms_sum_sq = 0.0;
+		worst_frame_ms = 0.f;
+		return report;
+	}
+};
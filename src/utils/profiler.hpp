@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Comment out to compile every PROFILE_SCOPE away
+#define PROFILING_ENABLED
+
+// Records named time spans into a fixed ring buffer and writes them out as a Chrome trace
+// (load the file in chrome://tracing or https://ui.perfetto.dev).
+// Recording is off by default, while off a scope costs one flag check.
+class Profiler
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Power of two so the write index can wrap with a mask
+	static constexpr uint32_t EVENT_CAPACITY = 1u << 16;
+
+	struct Event {
+		const char* name;	// string literal, only the pointer is stored
+		int64_t start_ns;
+		int64_t duration_ns;
+		uint32_t frame;
+	};
+
+	std::vector<Event> events;
+	// Total number of events ever recorded, a writer claims its slot with one fetch_add
+	std::atomic<uint64_t> write_count{ 0 };
+	uint32_t frame = 0;
+	Clock::time_point epoch = Clock::now();
+
+public:
+	bool recording = false;
+
+	void set_recording(bool enabled) {
+		if (enabled && events.empty())
+			events.resize(EVENT_CAPACITY);
+		recording = enabled;
+	}
+
+	// Marks the start of a new frame, dumps select frames by this counter
+	void begin_frame() { frame++; }
+
+	int64_t now_ns() const {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count();
+	}
+
+	void record(const char* name, int64_t start_ns, int64_t end_ns) {
+		uint64_t i = write_count.fetch_add(1, std::memory_order_relaxed);
+		events[i & (EVENT_CAPACITY - 1)] = { name, start_ns, end_ns - start_ns, frame };
+	}
+
+	// Writes the events of the last num_frames frames (that are still in the ring buffer) as trace_event JSON
+	bool write_chrome_trace(const std::string& path, uint32_t num_frames) const {
+		std::ofstream file(path);
+		if (!file.is_open())
+			return false;
+
+		uint64_t count = write_count.load(std::memory_order_relaxed);
+		uint64_t first = count > EVENT_CAPACITY ? count - EVENT_CAPACITY : 0;
+		uint32_t first_frame = frame >= num_frames ? frame - num_frames + 1 : 0;
+
+		file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+		bool comma = false;
+		for (uint64_t i = first; i < count; i++) {
+			const Event& event = events[i & (EVENT_CAPACITY - 1)];
+			if (event.frame < first_frame)
+				continue;
+			// Complete events, timestamps and durations in microseconds
+			file << (comma ? ",\n" : "\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":"
+				 << event.start_ns / 1000.0 << ",\"dur\":" << event.duration_ns / 1000.0 << ",\"args\":{\"frame\":" << event.frame << "}}";
+			comma = true;
+		}
+		file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+		return file.good();
+	}
+};
+
+inline Profiler profiler;
+
+// Systems whose time per frame the performance overlay shows
+enum class PERF_SYSTEM {
+	WORLD = 0,
+	FIRE,
+	PHYSICS,
+	AI,
+	PARTICLES,
+	RENDER,
+	PERF_SYSTEM_COUNT
+};
+const int perf_system_count = (int)PERF_SYSTEM::PERF_SYSTEM_COUNT;
+
+// Work counted per frame for the performance overlay
+enum class PERF_COUNTER {
+	COLLISIONS = 0,
+	PATH_EXPANSIONS,	// flow field cells expanded by rebuilds and repairs
+	DRAW_CALLS,
+	PERF_COUNTER_COUNT
+};
+const int perf_counter_count = (int)PERF_COUNTER::PERF_COUNTER_COUNT;
+
+// Rolling frame times plus per-system times and work counters, averaged over a window the overlay reads and resets.
+// System times are only measured while enabled, counters are plain increments and always kept.
+class PerfStats
+{
+	static constexpr int FRAME_HISTORY = 256;
+
+	std::array<float, FRAME_HISTORY> frame_ms = {};
+	int frame_head = 0;
+	int frame_history_count = 0;
+
+	// Totals of the current window
+	int window_frames = 0;
+	std::array<int64_t, perf_system_count> system_ns = {};
+	std::array<uint64_t, perf_counter_count> counters = {};
+
+	mutable std::vector<float> sorted_frame_ms;
+
+public:
+	bool enabled = false;
+
+	void add_time(PERF_SYSTEM system, int64_t ns) { system_ns[(int)system] += ns; }
+	void count(PERF_COUNTER counter, uint64_t n = 1) { counters[(int)counter] += n; }
+
+	void end_frame(float elapsed_ms) {
+		frame_ms[frame_head] = elapsed_ms;
+		frame_head = (frame_head + 1) % FRAME_HISTORY;
+		frame_history_count = std::min(frame_history_count + 1, FRAME_HISTORY);
+		window_frames++;
+	}
+
+	// Frame time percentile (0 to 100) over the last FRAME_HISTORY frames
+	float frame_percentile(float percentile) const {
+		if (frame_history_count == 0)
+			return 0.f;
+		sorted_frame_ms.assign(frame_ms.begin(), frame_ms.begin() + frame_history_count);
+		size_t k = std::min((size_t)(percentile / 100.f * frame_history_count), sorted_frame_ms.size() - 1);
+		std::nth_element(sorted_frame_ms.begin(), sorted_frame_ms.begin() + k, sorted_frame_ms.end());
+		return sorted_frame_ms[k];
+	}
+
+	// Mean per frame over the current window
+	float system_ms(PERF_SYSTEM system) const {
+		return window_frames > 0 ? system_ns[(int)system] / 1e6f / window_frames : 0.f;
+	}
+	float counter(PERF_COUNTER counter) const {
+		return window_frames > 0 ? (float)counters[(int)counter] / window_frames : 0.f;
+	}
+
+	void reset_window() {
+		window_frames = 0;
+		system_ns.fill(0);
+		counters.fill(0);
+	}
+};
+
+inline PerfStats perf_stats;
+
+// Times the enclosing scope, optionally adding the time to a system of the performance overlay
+class ProfileScope
+{
+	const char* name;
+	PERF_SYSTEM system;
+	int64_t start_ns = -1;
+
+public:
+	explicit ProfileScope(const char* name, PERF_SYSTEM system = PERF_SYSTEM::PERF_SYSTEM_COUNT) : name(name), system(system) {
+		if (profiler.recording || (system != PERF_SYSTEM::PERF_SYSTEM_COUNT && perf_stats.enabled))
+			start_ns = profiler.now_ns();
+	}
+	~ProfileScope() {
+		if (start_ns < 0)
+			return;
+		int64_t end_ns = profiler.now_ns();
+		// A scope that started before recording was switched on is not recorded
+		if (profiler.recording)
+			profiler.record(name, start_ns, end_ns);
+		if (system != PERF_SYSTEM::PERF_SYSTEM_COUNT && perf_stats.enabled)
+			perf_stats.add_time(system, end_ns - start_ns);
+	}
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef PROFILING_ENABLED
+// PROFILE_SCOPE("name") times the rest of the enclosing block, the name must be a string literal
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+// Same, and adds the time to a PERF_SYSTEM of the performance overlay
+#define PROFILE_SYSTEM_SCOPE(name, system) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name, system)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_SYSTEM_SCOPE(name, system) ((void)0)
+#endif
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <stdint.h>
+#include <tuple>
+#include <vector>
+
+#include "tinyECS/components.hpp"
+
+// The batching rules of RenderSystem's sprite batch without any gl state, so that "bench sprites" counts draw calls
+// with the same rules the renderer draws with.
+
+// TEXTURED, POWERUP and FIRE sprites go through the batch, anything else is drawn on its own
+inline bool isBatchedSprite(const RenderRequest& render_request)
+{
+	return render_request.used_geometry == GEOMETRY_BUFFER_ID::SPRITE &&
+		(render_request.used_effect == EFFECT_ASSET_ID::TEXTURED ||
+		 render_request.used_effect == EFFECT_ASSET_ID::POWERUP ||
+		 render_request.used_effect == EFFECT_ASSET_ID::FIRE);
+}
+
+// Only lit TEXTURED sprites bind a normal map
+inline bool usesNormalTexture(const RenderRequest& render_request)
+{
+	return render_request.used_effect == EFFECT_ASSET_ID::TEXTURED && render_request.used_normal_strength > 0.0f &&
+		render_request.used_normal_texture != TEXTURE_ASSET_ID::TEXTURE_COUNT;
+}
+
+// Queued sprites with the same key share a draw call. Texture is what gets bound: gl texture handles in the renderer,
+// where 0 stands for no normal map, texture assets in the bench.
+template <typename Texture>
+struct SpriteBatchKey {
+	EFFECT_ASSET_ID effect;
+	Texture texture;
+	Texture normal_texture;
+
+	bool operator==(const SpriteBatchKey& other) const {
+		return effect == other.effect && texture == other.texture && normal_texture == other.normal_texture;
+	}
+	bool operator<(const SpriteBatchKey& other) const {
+		return std::tie(effect, texture, normal_texture) < std::tie(other.effect, other.texture, other.normal_texture);
+	}
+};
+
+// Fills order with the draw order of the queued keys: queue order, or grouped by key when any_order is set, which is
+// only allowed for passes whose result does not depend on draw order
+template <typename Texture>
+void orderSpriteBatch(const std::vector<SpriteBatchKey<Texture>>& keys, bool any_order, std::vector<uint32_t>& order)
+{
+	order.resize(keys.size());
+	for (size_t k = 0; k < keys.size(); k++) {
+		order[k] = (uint32_t)k;
+	}
+	if (any_order) {
+		std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+	}
+}
+
+// Calls draw_run(first, last) for every run [first, last) of positions in order whose keys are the same, one draw call each
+template <typename Texture, typename DrawRun>
+void forEachSpriteRun(const std::vector<SpriteBatchKey<Texture>>& keys, const std::vector<uint32_t>& order, DrawRun&& draw_run)
+{
+	for (size_t first = 0; first < order.size();) {
+		size_t last = first + 1;
+		while (last < order.size() && keys[order[last]] == keys[order[first]]) {
+			last++;
+		}
+		draw_run(first, last);
+		first = last;
+	}
+}
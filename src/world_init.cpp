@@ -63,6 +63,9 @@ Entity createObstacle(vec2 position, TEXTURE_ASSET_ID texture, TEXTURE_ASSET_ID
 
     registry.obstacles.emplace(entity);
 
+    // Walls never move
+    registry.staticBodies.emplace(entity);
+
     // Add Motion component to be able to render the wall blocks
     auto& motion = registry.motions.emplace(entity);
     motion.velocity = { 0.0f, 0.0f };
@@ -70,8 +73,9 @@ Entity createObstacle(vec2 position, TEXTURE_ASSET_ID texture, TEXTURE_ASSET_ID
     motion.hitbox = { GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX };
     motion.position = grid_coords_to_position(position);
     motion.collidable = true;
+    motion.collision_layer = COLLISION_LAYER::OBSTACLE;
 
-    registry.map_grid_coord_entityID[vec_to_pair(position)] = entity;
+    registry.grid.set(vec_to_pair(position), GRID_LAYER::OBSTACLE, entity);
     if (normal_texture == TEXTURE_ASSET_ID::TEXTURE_COUNT) {
         registry.renderRequests.insert(
             entity,
@@ -127,9 +131,10 @@ Entity createFireBlock(vec2 position, Direction direction) {
     motion.scale = { GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX };
     motion.hitbox = { FIRE_WIDTH_PX, FIRE_HEIGHT_PX };
     motion.collidable = true;
+    motion.collision_layer = COLLISION_LAYER::FIRE;
     motion.position = position;
 
-	registry.map_grid_coord_entityID[position_to_grid_coords(position)] = entity;
+	registry.grid.set(position_to_grid_coords(position), GRID_LAYER::FIRE, entity);
 	registry.renderRequests.insert(
 		entity,
 		{
@@ -280,6 +285,7 @@ Entity createPlayer(vec2 position) {
     motion.scale = { GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX};
     motion.hitbox = { GRID_CELL_WIDTH_PX*0.1f, GRID_CELL_HEIGHT_PX*0.25f};
     motion.collidable = true;
+    motion.collision_layer = COLLISION_LAYER::PLAYER;
     motion.position = position;
 
     AnimationState& anim_state = registry.animationStates.emplace(entity);
@@ -292,7 +298,7 @@ Entity createPlayer(vec2 position) {
         TEXTURE_ASSET_ID::PLAYER_DOWN_4
     };
 
-    registry.map_grid_coord_entityID[position_to_grid_coords(position)] = entity;
+    registry.grid.set(position_to_grid_coords(position), GRID_LAYER::PLAYER, entity);
     registry.renderRequests.insert(
         entity,
         {
@@ -399,6 +405,7 @@ Entity createIngredient(ivec2 position, int ing_type, bool is_correct, int stage
     motion.scale = { INGREDIENT_WIDTH_PX, INGREDIENT_HEIGHT_PX };
     motion.hitbox = { INGREDIENT_WIDTH_PX, INGREDIENT_HEIGHT_PX };
     motion.collidable = true;
+    motion.collision_layer = COLLISION_LAYER::INGREDIENT;
     motion.position = grid_coords_to_position(position);
     
     // Add stage component to ingredient
@@ -431,6 +438,7 @@ Entity createPowerup(ivec2 position, TEXTURE_ASSET_ID powerup) {
     motion.scale = { POWERUP_WIDTH_PX, POWERUP_HEIGHT_PX };
     motion.hitbox = { 0.0f, 0.0f };
     motion.collidable = true;
+    motion.collision_layer = COLLISION_LAYER::POWERUP;
     motion.position = grid_coords_to_position(position);
     
     MeshCollider& c = registry.meshColliders.emplace(entity);
@@ -442,7 +450,7 @@ Entity createPowerup(ivec2 position, TEXTURE_ASSET_ID powerup) {
     p.type = PowerType::SPEEDBOOST;
     
     
-    registry.map_grid_coord_entityID[position_to_grid_coords(position)] = entity;
+    registry.grid.set(position_to_grid_coords(position), GRID_LAYER::POWERUP, entity);
     registry.renderRequests.insert(
 		entity,
 		{
@@ -485,6 +493,7 @@ Entity createEnemyMagma(ivec2 position, PATHFINDING_ID pid) {
     motion.scale = { BOUNCE_WIDTH_PX, BOUNCE_HEIGHT_PX };
     motion.hitbox = { GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX };
     motion.collidable = true;
+    motion.collision_layer = COLLISION_LAYER::ENEMY;
     
     motion.velocity = AISystem::getRandomDirection()*ENEMY_BOUNCE_SPEED;
     
@@ -504,7 +513,7 @@ Entity createEnemyMagma(ivec2 position, PATHFINDING_ID pid) {
         TEXTURE_ASSET_ID::ENEMY_MAGMA_DOWN4
     };
 
-    registry.map_grid_coord_entityID[vec_to_pair(position)] = entity;
+    registry.grid.set(vec_to_pair(position), GRID_LAYER::ENEMY, entity);
     registry.renderRequests.insert(
         entity,
         {
@@ -528,6 +537,7 @@ Entity createEnemySlime(ivec2 position, PATHFINDING_ID pid) {
     motion.scale = { WATER_WIDTH_PX, WATER_HEIGHT_PX };
     motion.hitbox = { WATER_WIDTH_PX, WATER_HEIGHT_PX };
     motion.collidable = true;
+    motion.collision_layer = COLLISION_LAYER::ENEMY;
 
     motion.velocity = AISystem::getRandomDirection()*ENEMY_BOUNCE_SPEED;
     
@@ -549,7 +559,7 @@ Entity createEnemySlime(ivec2 position, PATHFINDING_ID pid) {
     animationState.ms_per_frame = 100;
     animationState.flip_flop = true;
     
-    registry.map_grid_coord_entityID[vec_to_pair(position)] = entity;
+    registry.grid.set(vec_to_pair(position), GRID_LAYER::ENEMY, entity);
     registry.renderRequests.insert(
         entity,
         {
@@ -573,6 +583,7 @@ Entity createEnemyTornado(ivec2 position, PATHFINDING_ID pid) {
     motion.scale = { TORCH_WIDTH_PX, TORCH_HEIGHT_PX };
     motion.hitbox = { TORCH_WIDTH_PX, TORCH_HEIGHT_PX };
     motion.collidable = true;
+    motion.collision_layer = COLLISION_LAYER::ENEMY;
 
     motion.velocity = AISystem::getRandomDirection()*TORCH_SPEED;
     
@@ -591,7 +602,7 @@ Entity createEnemyTornado(ivec2 position, PATHFINDING_ID pid) {
         TEXTURE_ASSET_ID::ENEMY_TORNADO_DOWN4
     };
 
-    registry.map_grid_coord_entityID[vec_to_pair(position)] = entity;
+    registry.grid.set(vec_to_pair(position), GRID_LAYER::ENEMY, entity);
     registry.renderRequests.insert(
         entity,
         {
@@ -16,6 +16,7 @@
 #include "physics_system.hpp"
 #include "map_generator.hpp"
 #include "utils/button_helper.hpp"
+#include "utils/profiler.hpp"
 
 float player_death_timer_ms = -1.f; 
 float out_of_time_timer_ms = -1.f;
@@ -24,8 +25,8 @@ float player_win_timer_ms = -1.f;
 Mix_Chunk* fire_destroy = nullptr;
 // create the world
 WorldSystem::WorldSystem() : fpsTextVisible(true), fpsTimerUpdate(FPS_TEXT_UPDATE_MS) {
-   // seeding rng with random device
-   rng = std::default_random_engine(std::random_device()());
+   // seeding rng with random device, an input replay reseeds it with the recorded seed
+   seed_random(std::random_device()());
 }
 
 
@@ -38,10 +39,14 @@ WorldSystem::~WorldSystem() {
 
 
    // Close the window
-   glfwDestroyWindow(window);
+#ifndef HEADLESS_ONLY
+   if (window != nullptr)
+       glfwDestroyWindow(window);
+#endif
 }
 
 
+#ifndef HEADLESS_ONLY
 // Debugging
 namespace {
    void glfw_err_cb(int error, const char *desc) {
@@ -54,12 +59,19 @@ namespace {
 void WorldSystem::close_window() {
    glfwSetWindowShouldClose(window, GLFW_TRUE);
 }
+#else
+// The headless build links neither GLFW nor SDL, it has no window to close
+void WorldSystem::close_window() {
+}
+#endif
 
 
 // World initialization
 // Note, this has a lot of OpenGL specific things, could be moved to the renderer
 GLFWwindow* WorldSystem::create_window() {
-
+#ifdef HEADLESS_ONLY
+   return nullptr;
+#else
 
    ///////////////////////////////////////
    // Initialize GLFW
@@ -99,9 +111,9 @@ GLFWwindow* WorldSystem::create_window() {
    // Input is handled using GLFW, for more info see
    // http://www.glfw.org/docs/latest/input_guide.html
    glfwSetWindowUserPointer(window, this);
-   auto key_redirect = [](GLFWwindow* wnd, int _0, int _1, int _2, int _3) { ((WorldSystem*)glfwGetWindowUserPointer(wnd))->on_key(_0, _1, _2, _3); };
-   auto cursor_pos_redirect = [](GLFWwindow* wnd, double _0, double _1) { ((WorldSystem*)glfwGetWindowUserPointer(wnd))->on_mouse_move({ _0, _1 }); };
-   auto mouse_button_pressed_redirect = [](GLFWwindow* wnd, int _button, int _action, int _mods) { ((WorldSystem*)glfwGetWindowUserPointer(wnd))->on_mouse_button_pressed(_button, _action, _mods); };
+   auto key_redirect = [](GLFWwindow* wnd, int _0, int _1, int _2, int _3) { ((WorldSystem*)glfwGetWindowUserPointer(wnd))->on_window_key(_0, _1, _2, _3); };
+   auto cursor_pos_redirect = [](GLFWwindow* wnd, double _0, double _1) { ((WorldSystem*)glfwGetWindowUserPointer(wnd))->on_window_mouse_move({ _0, _1 }); };
+   auto mouse_button_pressed_redirect = [](GLFWwindow* wnd, int _button, int _action, int _mods) { ((WorldSystem*)glfwGetWindowUserPointer(wnd))->on_window_mouse_button(_button, _action, _mods); };
 
 
    glfwSetKeyCallback(window, key_redirect);
@@ -113,11 +125,14 @@ GLFWwindow* WorldSystem::create_window() {
 
 
    return window;
+#endif
 }
 
 
 bool WorldSystem::start_and_load_sounds() {
-  
+#ifdef HEADLESS_ONLY
+   return false;
+#else
    //////////////////////////////////////
    // Loading music and sounds with SDL
    if (SDL_Init(SDL_INIT_AUDIO) < 0) {
@@ -130,6 +145,7 @@ bool WorldSystem::start_and_load_sounds() {
        fprintf(stderr, "Failed to open audio device");
        return false;
    }
+   audio_open = true;
 
 
    gameplay_music = Mix_LoadMUS(audio_path("main.wav").c_str());
@@ -170,6 +186,7 @@ bool WorldSystem::start_and_load_sounds() {
    }
 
    return true;
+#endif
 }
 
 
@@ -179,14 +196,19 @@ void WorldSystem::init(MapGenerator* map_generator_arg, PopupWindow& pop_window_
 	this->map_generator = map_generator_arg;
 	this->popup_window = pop_window_arg;
    
-	// start playing background music indefinitely
-	std::cout << "Starting music..." << std::endl;
-	Mix_PlayMusic(startscreen_music, -1);
-
-	// Create the arrow and hand cursors 
-	hand_cursor = glfwCreateStandardCursor(GLFW_HAND_CURSOR);
-	arrow_cursor = glfwCreateStandardCursor(GLFW_ARROW_CURSOR);
-	glfwSetWindowTitle(window, "Bad Chilli Peppers");
+	// Headless runs have neither a window nor audio
+#ifndef HEADLESS_ONLY
+	if (window != nullptr) {
+		// start playing background music indefinitely
+		std::cout << "Starting music..." << std::endl;
+		Mix_PlayMusic(startscreen_music, -1);
+
+		// Create the arrow and hand cursors 
+		hand_cursor = glfwCreateStandardCursor(GLFW_HAND_CURSOR);
+		arrow_cursor = glfwCreateStandardCursor(GLFW_ARROW_CURSOR);
+		glfwSetWindowTitle(window, "Bad Chilli Peppers");
+	}
+#endif
 
 	// Set all states to default
 	restart_game();
@@ -207,24 +229,20 @@ void WorldSystem::update_window_title(float elapsed_ms) {
 void WorldSystem::remove_debug_entities() {
    // Remove debug info from the last step
    while (registry.debugComponents.entities.size() > 0)
-           registry.remove_all_components_of(registry.debugComponents.entities.back());
+           registry.destroy_entity(registry.debugComponents.entities.back());
 }
 
 
 void WorldSystem::remove_out_of_bounds_entities() {
-   // Removing out of screen entities
-   auto& motions_registry = registry.motions;
-
-
-   // Remove entities that leave the screen on the left side
+   // Enemies are the only bodies physics moves (the player is never removed, static geometry and the
+   // rest of the level keep a zero velocity), so only they can leave the screen on the left side.
    // Iterate backwards to be able to remove without unterfering with the next object to visit
    // (the containers exchange the last element with the current)
-   for (int i = (int)motions_registry.components.size()-1; i>=0; --i) {
-           Motion& motion = motions_registry.components[i];
-       if (motion.position.x + abs(motion.scale.x) < 0.f) {
-           if(!registry.players.has(motions_registry.entities[i])) // don't remove the player
-               registry.remove_all_components_of(motions_registry.entities[i]);
-       }
+   for (int i = (int)registry.enemies.entities.size()-1; i>=0; --i) {
+       Entity entity = registry.enemies.entities[i];
+       Motion* motion = registry.motions.try_get(entity);
+       if (motion != nullptr && motion->position.x + abs(motion->scale.x) < 0.f)
+           registry.destroy_entity(entity);
    }
 }
 
@@ -318,8 +336,10 @@ void WorldSystem::update_hud(float elapsed_ms) {
         }
     }
 	game_state.timer = timer; 
-	
-	// Update fps text every 500ms
+}
+
+void WorldSystem::update_fps_text(float elapsed_ms) {
+	// Update fps text every FPS_TEXT_UPDATE_MS
 	if (fpsTimerUpdate < 0.f) {
 		if (fpsText.has_value() && registry.textRenderRequests.has(fpsText.value())) {
 			TextRenderRequest& text = registry.textRenderRequests.get(fpsText.value());
@@ -327,12 +347,52 @@ void WorldSystem::update_hud(float elapsed_ms) {
 			ss << std::setfill('0') << std::setw(3) << (int)(1000/elapsed_ms) << " fps";
 			text.text = ss.str();
 		}
+		update_perf_overlay();
 		fpsTimerUpdate = FPS_TEXT_UPDATE_MS;
 	} else {
 		fpsTimerUpdate -= elapsed_ms;
 	}
 }
 
+void WorldSystem::toggle_perf_overlay() {
+	if (perfOverlayLines.empty()) {
+		for (int i = 0; i < PERF_OVERLAY_LINE_COUNT; i++) {
+			Entity line = createText("", GAME_SCREEN::PLAYING, { 20, WINDOW_HEIGHT_PX-90-30*i }, 0.5f, false);
+			registry.textRenderRequests.get(line).isDynamic = true;
+			perfOverlayLines.push_back(line);
+		}
+		// System times are only measured while the overlay is shown
+		perf_stats.reset_window();
+		perf_stats.enabled = true;
+	} else {
+		for (Entity line : perfOverlayLines) {
+			registry.destroy_entity(line);
+		}
+		perfOverlayLines.clear();
+		perf_stats.enabled = false;
+	}
+}
+
+// Shows the frame time percentiles, and the per-frame system times and counters averaged since the last update
+void WorldSystem::update_perf_overlay() {
+	if (perfOverlayLines.empty()) return;
+
+	std::stringstream lines[PERF_OVERLAY_LINE_COUNT];
+	lines[0] << std::fixed << std::setprecision(1) << "frame ms  p50 " << perf_stats.frame_percentile(50.f)
+			 << "  p95 " << perf_stats.frame_percentile(95.f) << "  p99 " << perf_stats.frame_percentile(99.f);
+	lines[1] << std::fixed << std::setprecision(2) << "world " << perf_stats.system_ms(PERF_SYSTEM::WORLD)
+			 << "  fire " << perf_stats.system_ms(PERF_SYSTEM::FIRE) << "  physics " << perf_stats.system_ms(PERF_SYSTEM::PHYSICS);
+	lines[2] << std::fixed << std::setprecision(2) << "ai " << perf_stats.system_ms(PERF_SYSTEM::AI)
+			 << "  particles " << perf_stats.system_ms(PERF_SYSTEM::PARTICLES) << "  render " << perf_stats.system_ms(PERF_SYSTEM::RENDER);
+	lines[3] << "entities " << Entity::live_count() << "  particles " << registry.particles.size();
+	lines[4] << std::fixed << std::setprecision(0) << "per frame  collisions " << perf_stats.counter(PERF_COUNTER::COLLISIONS)
+			 << "  path expansions " << perf_stats.counter(PERF_COUNTER::PATH_EXPANSIONS) << "  draws " << perf_stats.counter(PERF_COUNTER::DRAW_CALLS);
+
+	for (int i = 0; i < PERF_OVERLAY_LINE_COUNT; i++) {
+		registry.textRenderRequests.get(perfOverlayLines[i]).text = lines[i].str();
+	}
+	perf_stats.reset_window();
+}
 
 void WorldSystem::update_animation_states(float elapsed_ms) {
     for (int i = 0; i < (int)registry.animationStates.size(); i++) {
@@ -367,7 +427,7 @@ int WorldSystem::handle_powerups(float elapsed_ms) {
                player.speed /= POWERUP_SPEED_BOOST;
                powerup.active = false;
                DEBUG_LOG << "POWERUP EXPIRED";
-               registry.remove_all_components_of(powerup_entity);
+               registry.destroy_entity(powerup_entity);
            } else {
                active_powerups++;  
            }
@@ -394,9 +454,14 @@ GameState& WorldSystem::get_game_state() {
 }
 
 
+#ifndef HEADLESS_ONLY
 void WorldSystem::update_sounds(GAME_SCREEN game_screen) {
     Mix_Music* new_music = nullptr;
     GameState& game_state = registry.game_state.get(registry.game_state.entities[0]);
+
+    if (!audio_open) {
+        return;
+    }
    
     if (music_muted || game_state.show_popup) {
         Mix_VolumeMusic(0);
@@ -435,8 +500,36 @@ void WorldSystem::update_sounds(GAME_SCREEN game_screen) {
 
 }
 
+void WorldSystem::play_sound(Mix_Chunk* sound, int volume, int channel) {
+	if (sound) {
+		Mix_Volume(channel, volume);
+		Mix_PlayChannel(channel, sound, 0);
+	}
+}
+
+void WorldSystem::play_jingle(Mix_Chunk* sound) {
+	if (sound) {
+		Mix_HaltMusic();
+		Mix_Volume(-1, MIX_MAX_VOLUME / 2);
+		Mix_PlayChannel(-1, sound, 0);
+		current_music = nullptr;
+	}
+}
+#else
+// Without SDL_mixer nothing is ever loaded or played
+void WorldSystem::update_sounds(GAME_SCREEN game_screen) {
+}
+
+void WorldSystem::play_sound(Mix_Chunk* sound, int volume, int channel) {
+}
+
+void WorldSystem::play_jingle(Mix_Chunk* sound) {
+}
+#endif
+
 // Update our game world
 bool WorldSystem::step(float elapsed_ms_since_last_update) {
+	PROFILE_SYSTEM_SCOPE("WorldSystem::step", PERF_SYSTEM::WORLD);
 
 	GameState& game_state = get_game_state();
 
@@ -489,12 +582,7 @@ void WorldSystem::check_level_death()
 	
 	player.player_state = PlayerState::DEAD;
 	
-	if (game_over) {
-		Mix_HaltMusic();
-		Mix_Volume(-1, MIX_MAX_VOLUME / 2); 
-		Mix_PlayChannel(-1, game_over, 0);
-		current_music = nullptr;
-	}
+	play_jingle(game_over);
 
 	RenderRequest& rr = registry.renderRequests.get(player_entity);
 	rr.used_texture = TEXTURE_ASSET_ID::PLAYER_DEATH;
@@ -552,12 +640,7 @@ void WorldSystem::check_level_timeout() {
 		return;
 	}
 	
-	if (game_over) {
-		Mix_HaltMusic(); 
-		Mix_Volume(-1, MIX_MAX_VOLUME / 2); 
-		Mix_PlayChannel(-1, game_over, 0);
-		current_music = nullptr;
-	}	
+	play_jingle(game_over);
 	
 	auto player_entity = registry.players.entities[0];
 	auto& player = registry.players.get(player_entity);
@@ -637,17 +720,14 @@ void WorldSystem::check_level_complete() {
 		player_win_timer_ms = 1000.f;
 	}
 
-	if (win_sound) {
-		Mix_HaltMusic();
-		Mix_Volume(-1, MIX_MAX_VOLUME / 2); 
-		Mix_PlayChannel(-1, win_sound, 0);
-		current_music = nullptr;
-	}
+	play_jingle(win_sound);
 		
 	update_sounds(GAME_SCREEN::PLAYING);
 	
-	// Save the game state
-	persistence_system.save("save_00.json");
+	// Save the game state, headless runs and replays leave the player's save alone
+	if (window != nullptr && (input_recorder == nullptr || !input_recorder->replaying())) {
+		persistence_system.save("save_00.json");
+	}
 }
 
 void WorldSystem::handle_level_complete(float elapsed_ms) {
@@ -685,7 +765,7 @@ void WorldSystem::handle_ingredients_burning(float elapsed_ms) {
    	for (Entity ingredient_entity : registry.ingredients.entities) {
 		Ingredient& ingredient = registry.ingredients.get(ingredient_entity);
 		if (!ingredient.isCorrect && ingredient.isBurning) {
-			registry.remove_all_components_of(ingredient_entity);
+			registry.destroy_entity(ingredient_entity);
 		}
 	}
 }
@@ -897,7 +977,22 @@ void WorldSystem::restart_game() {
 	   
 	DEBUG_LOG << "Loading saved data";
    
-	persistence_system.load("save_00.json");
+	// A replay starts from the unlocks stored in its recording instead of the local save
+	if (input_recorder != nullptr && input_recorder->replaying()) {
+		uint32_t unlocked = input_recorder->recorded_unlocked_levels();
+		for (int i = 0; i < REAL_LEVEL_COUNT; i++) {
+			game_state.levels[i].id = (LEVEL_ASSET_ID)(i + (int)LEVEL_ASSET_ID::LEVEL_1);
+			game_state.levels[i].unlocked = (unlocked >> i) & 1;
+		}
+	} else {
+		persistence_system.load("save_00.json");
+		if (input_recorder != nullptr) {
+			uint32_t unlocked = 0;
+			for (int i = 0; i < REAL_LEVEL_COUNT; i++)
+				unlocked |= (uint32_t)game_state.levels[i].unlocked << i;
+			input_recorder->set_unlocked_levels(unlocked);
+		}
+	}
 	
 	for (int i = 0; i < REAL_LEVEL_COUNT; i++) {
 		if (game_state.levels[i].unlocked) {
@@ -926,6 +1021,7 @@ void WorldSystem::restart_game() {
 
 // Compute collisions between entities
 void WorldSystem::handle_collisions() {
+   PROFILE_SYSTEM_SCOPE("WorldSystem::handle_collisions", PERF_SYSTEM::WORLD);
    GameState& game_state = get_game_state();
 
    if (registry.players.entities.empty()) return;
@@ -967,18 +1063,12 @@ void WorldSystem::handle_collisions() {
 			if (!ingredient.isCorrect) {
 				game_state.red_flash_timer = INCORRECT_INGREDIENT_TIMER_EFFECT_MS;
 				game_state.timer -= INCORRECT_INGREDIENT_PENALTY_MS;
-				if (pickup_wrong_sound) {
-					Mix_Volume(-1, MIX_MAX_VOLUME/2);
-					Mix_PlayChannel(-1, pickup_wrong_sound, 0);
-				}
+				play_sound(pickup_wrong_sound, MIX_MAX_VOLUME/2);
 			}
 			else {
-				if (pickup_correct_sound) {
-					Mix_Volume(-1, MIX_MAX_VOLUME/2);
-					Mix_PlayChannel(-1, pickup_correct_sound, 0);
-				}
+				play_sound(pickup_correct_sound, MIX_MAX_VOLUME/2);
 			}
-			registry.remove_all_components_of(other_entity);
+			registry.destroy_entity(other_entity);
 			update_hud_ingredients();
 			check_level_complete();
        	} else if (is_player_ingredient_collision(other_entity, this_entity)) {
@@ -987,18 +1077,12 @@ void WorldSystem::handle_collisions() {
 			if (!ingredient.isCorrect) {
 				game_state.red_flash_timer = INCORRECT_INGREDIENT_TIMER_EFFECT_MS;
 				game_state.timer -= INCORRECT_INGREDIENT_PENALTY_MS;
-				if (pickup_wrong_sound) {
-                   	Mix_Volume(-1, MIX_MAX_VOLUME/2);
-                   	Mix_PlayChannel(-1, pickup_wrong_sound, 0);
-               	}
+				play_sound(pickup_wrong_sound, MIX_MAX_VOLUME/2);
            	}
            	else {
-               if (pickup_correct_sound) {
-                   Mix_Volume(-1, MIX_MAX_VOLUME/2);
-                   Mix_PlayChannel(-1, pickup_correct_sound, 0);
-               }
+               play_sound(pickup_correct_sound, MIX_MAX_VOLUME/2);
            	}
-           	registry.remove_all_components_of(this_entity);
+           	registry.destroy_entity(this_entity);
 			update_hud_ingredients();
             check_level_complete();
        }
@@ -1012,10 +1096,7 @@ void WorldSystem::handle_collisions() {
            registry.renderRequests.remove(other_entity);
            registry.collisions.remove(other_entity);
            registry.motions.remove(other_entity);
-           if (powerup_sound) {
-               Mix_Volume(-1, MIX_MAX_VOLUME/2);
-               Mix_PlayChannel(-1, powerup_sound, 0);
-           }
+           play_sound(powerup_sound, MIX_MAX_VOLUME/2);
 
 
            DEBUG_LOG << "POWERUP ACTIVE: Speed increased!";
@@ -1053,7 +1134,11 @@ void WorldSystem::handle_collisions() {
 
 // Should the game be over ?
 bool WorldSystem::is_over() const {
+#ifdef HEADLESS_ONLY
+   return true;
+#else
    return bool(glfwWindowShouldClose(window));
+#endif
 }
 
 
@@ -1073,6 +1158,19 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
        GameState& game_state = get_game_state();
        std::optional<BUTTON_ID> button_id;
 
+       // Profiler controls work on every screen
+       if (action == GLFW_RELEASE && key == GLFW_KEY_F8) {
+           profiler.set_recording(!profiler.recording);
+           DEBUG_LOG << "Profiler recording " << (profiler.recording ? "on" : "off");
+       }
+       if (action == GLFW_RELEASE && key == GLFW_KEY_F9) {
+           std::string path = trace_path(PROFILER_TRACE_FILE);
+           if (profiler.write_chrome_trace(path, PROFILER_TRACE_FRAMES)) {
+               DEBUG_LOG << "Wrote profiler trace to " << path;
+           } else {
+               ERROR_LOG << "Could not write profiler trace to " << path;
+           }
+       }
 
        // ESC opens settings menu only if no popups are displayed
        if (action == GLFW_RELEASE && key == GLFW_KEY_ESCAPE) {
@@ -1153,6 +1251,9 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
                     }
                     fpsTextVisible = !fpsTextVisible;
                 }
+                if (action == GLFW_RELEASE && key == GLFW_KEY_F3) {
+                    toggle_perf_overlay();
+                }
             
                 Entity player_entity = registry.players.entities[0];
                 Player& player = registry.players.get(player_entity);
@@ -1162,10 +1263,7 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
                     if (player.player_state == PlayerState::IDLE) {
                         bool successful = FireSystem::handleFireBlockChainInteraction(player_motion.position, player.direction, true, false);
                         if (successful) {
-                            if (fire_sound) {
-                                Mix_Volume(1, MIX_MAX_VOLUME/2);
-                                Mix_PlayChannel(1, fire_sound, 0);
-                            }
+                            play_sound(fire_sound, MIX_MAX_VOLUME/2, 1);
                             player.fire_queued = false;
                             player.move_timeout_ms = PLAYER_MOVE_TIMEOUT_MS;
                             player.fire_timeout_ms = PLAYER_FIRE_TIMEOUT_MS;
@@ -1230,6 +1328,30 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 }
 
 
+void WorldSystem::on_window_key(int key, int scancode, int action, int mod) {
+   if (input_recorder != nullptr) {
+       if (input_recorder->replaying()) return;
+       input_recorder->record_key(key, action, mod);
+   }
+   on_key(key, scancode, action, mod);
+}
+
+void WorldSystem::on_window_mouse_move(vec2 mouse_position) {
+   if (input_recorder != nullptr) {
+       if (input_recorder->replaying()) return;
+       input_recorder->record_mouse_move(mouse_position);
+   }
+   on_mouse_move(mouse_position);
+}
+
+void WorldSystem::on_window_mouse_button(int button, int action, int mods) {
+   if (input_recorder != nullptr) {
+       if (input_recorder->replaying()) return;
+       input_recorder->record_mouse_button(button, action, mods);
+   }
+   on_mouse_button_pressed(button, action, mods);
+}
+
 void WorldSystem::on_mouse_move(vec2 mouse_position) {
 
 
@@ -1279,10 +1401,7 @@ void WorldSystem::handle_button(BUTTON_ID button_id) {
 
 
    DEBUG_LOG << "PRESSED " << BUTTON_ID_NAMES[(int)button_id];
-   if (menuclick_sound) {
-       Mix_Volume(-1, MIX_MAX_VOLUME/4);
-       Mix_PlayChannel(-1, menuclick_sound, 0);
-   }
+   play_sound(menuclick_sound, MIX_MAX_VOLUME/4);
 
 
     switch(button_id) {
@@ -1402,10 +1521,7 @@ void WorldSystem::handle_button(BUTTON_ID button_id) {
             popup_window.clearPopup();
         case BUTTON_ID::LEVEL_SELECT_END:
          	if (!game_state.levels[REAL_LEVEL_COUNT - 1].completed) {
-				if (pickup_wrong_sound) {
-					Mix_Volume(-1, MIX_MAX_VOLUME/2);
-					Mix_PlayChannel(-1, pickup_wrong_sound, 0);
-				}
+				play_sound(pickup_wrong_sound, MIX_MAX_VOLUME/2);
 				return;
 			}
             end_screen.init();
@@ -1442,10 +1558,7 @@ void WorldSystem::load_level(LEVEL_ASSET_ID level_id) {
 	GameState& game_state = get_game_state();
 	
 	if (!game_state.levels[index].unlocked) {
-		if (pickup_wrong_sound) {
-			Mix_Volume(-1, MIX_MAX_VOLUME/2);
-			Mix_PlayChannel(-1, pickup_wrong_sound, 0);
-		}
+		play_sound(pickup_wrong_sound, MIX_MAX_VOLUME/2);
 		return;
 	}
 	
@@ -23,6 +23,7 @@
 #include "popup_window.hpp"
 #include "story_screen.hpp"
 #include "end_screen.hpp"
+#include "input_recorder.hpp"
 
 // Container for all our entities and game logic.
 // Individual rendering / updates are deferred to the update() methods.
@@ -52,6 +53,17 @@ public:
 	// check for collisions generated by the physics system
 	void handle_collisions();
 
+	// feed input events as if they came from the window, used to script input in headless runs and to replay recordings
+	void inject_key(int key, int action, int mod = 0) { on_key(key, 0, action, mod); }
+	void inject_mouse_move(vec2 pos) { on_mouse_move(pos); }
+	void inject_mouse_button(int button, int action, int mods) { on_mouse_button_pressed(button, action, mods); }
+
+	// window input is passed to the recorder while it records and ignored while it replays
+	void set_input_recorder(InputRecorder* recorder) { input_recorder = recorder; }
+
+	// updates the fps text and the performance overlay, called once per rendered frame rather than per simulation tick
+	void update_fps_text(float elapsed_ms);
+
     // Handle what to do for each button
     void handle_button(BUTTON_ID button_id);
 
@@ -78,6 +90,12 @@ private:
 	void on_mouse_move(vec2 pos);
 	void on_mouse_button_pressed(int button, int action, int mods);
 
+	// GLFW callbacks, go through the input recorder before the handlers above
+	void on_window_key(int key, int scancode, int action, int mod);
+	void on_window_mouse_move(vec2 pos);
+	void on_window_mouse_button(int button, int action, int mods);
+	InputRecorder* input_recorder = nullptr;
+
 	// anim function for enemy bounce
 	// @param is entity (enemy) and float elapsed ms
 	// void return
@@ -178,30 +196,37 @@ private:
 
 	//update background music based on game state
 	void update_sounds(GAME_SCREEN game_screen);
+
+	// Plays a sound effect at the given volume, does nothing for sounds that were not loaded
+	void play_sound(Mix_Chunk* sound, int volume, int channel = -1);
+	// Stops the music and plays the sound in its place, for the end of a level
+	void play_jingle(Mix_Chunk* sound);
 	
 	// restart level
 	void restart_game();
 
 	// OpenGL window handle
-	GLFWwindow* window;
+	GLFWwindow* window = nullptr;	// stays null in headless runs
 
     // Set the hand cursors
     GLFWcursor* hand_cursor;
     GLFWcursor* arrow_cursor;
 
 	//Music 
-	Mix_Music* gameplay_music;
-	Mix_Music* startscreen_music;
-	Mix_Music* story_music;
+	// Audio stays null unless start_and_load_sounds succeeds, e.g. in headless runs
+	bool audio_open = false;
+	Mix_Music* gameplay_music = nullptr;
+	Mix_Music* startscreen_music = nullptr;
+	Mix_Music* story_music = nullptr;
 	Mix_Music* current_music = nullptr;
-	Mix_Chunk* win_sound;
-	Mix_Chunk* powerup_sound;
-	Mix_Chunk* menuclick_sound;
-	Mix_Chunk* pickup_correct_sound;
-	Mix_Chunk* pickup_wrong_sound;
-	Mix_Chunk* game_start;
-	Mix_Chunk* fire_sound;
-	Mix_Chunk* game_over;
+	Mix_Chunk* win_sound = nullptr;
+	Mix_Chunk* powerup_sound = nullptr;
+	Mix_Chunk* menuclick_sound = nullptr;
+	Mix_Chunk* pickup_correct_sound = nullptr;
+	Mix_Chunk* pickup_wrong_sound = nullptr;
+	Mix_Chunk* game_start = nullptr;
+	Mix_Chunk* fire_sound = nullptr;
+	Mix_Chunk* game_over = nullptr;
 	bool music_muted = false;
 
 	// Initial game screen
@@ -212,6 +237,11 @@ private:
 	bool fpsTextVisible;
 	float fpsTimerUpdate;
 
+	// Performance overlay (F3), one text entity per line, empty while hidden
+	std::vector<Entity> perfOverlayLines;
+	void toggle_perf_overlay();
+	void update_perf_overlay();
+
 	// Start screen
 	StartScreen start_screen;
 	TutorialScreen tutorial_screen;
@@ -34,9 +34,9 @@ bool WorldSystem::handle_player_movement_while_lerp(float elapsed_ms_since_last_
 		player_motion.position = lerp(player.start_pos, player.end_pos, player.transition_factor);
 
 		// Rough solution to update player on grid-entity map
-		if (!registry.map_grid_coord_entityID[position_to_grid_coords(player.end_pos)].has_value() && player.transition_factor >= 0.5f) {
-			registry.map_grid_coord_entityID.erase(position_to_grid_coords(player.start_pos));
-			registry.map_grid_coord_entityID[position_to_grid_coords(player.end_pos)] = player_entity;
+		if (!registry.grid.has(position_to_grid_coords(player.end_pos), GRID_LAYER::PLAYER) && player.transition_factor >= 0.5f) {
+			registry.grid.unset(position_to_grid_coords(player.start_pos), GRID_LAYER::PLAYER, player_entity);
+			registry.grid.set(position_to_grid_coords(player.end_pos), GRID_LAYER::PLAYER, player_entity);
 		}
 		increment_transition_factor(player, elapsed_ms_since_last_update);
 	}
@@ -83,9 +83,8 @@ bool WorldSystem::handle_player_movement_while_idle(float elapsed_ms_since_last_
 		// Increment t-value before lerping because the previous frame did not move the player (t >= 1)
 		increment_transition_factor(player, elapsed_ms_since_last_update);
 
-		std::optional<Entity> e = registry.map_grid_coord_entityID[position_to_grid_coords(player.end_pos)];
 		// If the next cell is not occupied by an obstacle, and the player has not pressed a key for the "place/remove fire" action,
-		if ((!e.has_value() || !registry.obstacles.has(e.value())) && !player.fire_queued) {
+		if (!registry.grid.any(position_to_grid_coords(player.end_pos), BLOCKING_GRID_LAYERS) && !player.fire_queued) {
 			player.player_state = PlayerState::TRANSITION_TO_CELL;
 			// Lerp even in the IDLE state, iff the movement key was not released (this is done for smooth movement)
 			player_motion.position = lerp(player.start_pos, player.end_pos, player.transition_factor);
@@ -0,0 +1,130 @@
+// Entity handles and component containers, without the registry
+#include "tinyECS/tiny_ecs.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+
+// A destroyed handle must stay stale however often its index is recycled afterwards
+static void test_stale_handle_after_reuse() {
+	Entity stale;
+	ComponentContainer<int> values;
+	values.emplace(stale, 1);
+	values.remove(stale);
+	Entity::release(stale);
+
+	// Churn a small live set like the fire and particle entities do. A LIFO free list with 12 generation bits
+	// wrapped every index of this set many times over.
+	const int churn = 1 << 20;
+	std::vector<Entity> live;
+	for (int i = 0; i < churn; i++) {
+		Entity e;
+		values.emplace(e, i);
+		live.push_back(e);
+		if (live.size() > 16) {
+			values.remove(live.front());
+			Entity::release(live.front());
+			live.erase(live.begin());
+		}
+		if (e.index() == stale.index())
+			CHECK(e.id() != stale.id());
+	}
+	CHECK(!stale.is_alive());
+	CHECK(!values.has(stale));
+	CHECK(values.try_get(stale) == nullptr);
+	for (Entity e : live)
+		CHECK(e.is_alive());
+
+	// Releasing the stale handle again (e.g. destroying an already destroyed fire) must not touch a live entity
+	Entity::release(stale);
+	for (Entity e : live)
+		CHECK(e.is_alive());
+	for (Entity e : live) {
+		values.remove(e);
+		Entity::release(e);
+	}
+}
+
+// Released indices are only handed out again once enough others are queued behind them
+static void test_free_list_depth() {
+	Entity first;
+	unsigned int index = first.index();
+	Entity::release(first);
+	std::vector<Entity> created;
+	for (size_t i = 0; i < Entity::MIN_FREE_INDICES; i++) {
+		Entity e;
+		CHECK(e.index() != index);
+		created.push_back(e);
+	}
+	for (Entity e : created)
+		Entity::release(e);
+}
+
+// Batch removal leaves exactly the survivors, each still reachable through its own entity
+static void test_remove_batch() {
+	ComponentContainer<int> values;
+	std::vector<Entity> entities(100);
+	for (size_t i = 0; i < entities.size(); i++)
+		values.emplace(entities[i], (int)i);
+
+	std::vector<Entity> doomed;
+	for (size_t i = 0; i < entities.size(); i += 3)
+		doomed.push_back(entities[i]);
+	doomed.push_back(entities[0]); // duplicates are allowed
+	values.remove_batch(doomed);
+
+	CHECK(values.size() == entities.size() - (entities.size() + 2) / 3);
+	for (size_t i = 0; i < entities.size(); i++) {
+		bool removed = i % 3 == 0;
+		CHECK(values.has(entities[i]) == !removed);
+		if (!removed)
+			CHECK(values.get(entities[i]) == (int)i);
+	}
+	// The survivors keep their order
+	CHECK(std::is_sorted(values.components.begin(), values.components.end()));
+	for (Entity e : entities)
+		Entity::release(e);
+}
+
+// A view yields every entity that has all components, whichever of its containers is the smallest
+static void test_view() {
+	ComponentContainer<int> ints;
+	ComponentContainer<float> floats;
+	std::vector<Entity> entities(10);
+	for (size_t i = 0; i < entities.size(); i++)
+		ints.emplace(entities[i], (int)i);
+	for (size_t i = 0; i < entities.size(); i += 4)
+		floats.emplace(entities[i], (float)i);
+	// Reorder the driving container so its dense order differs from the other one's
+	floats.remove(entities[0]);
+	floats.emplace(entities[0], 0.f);
+
+	// Driven by floats, the second container
+	size_t visited = 0;
+	for (auto [e, i, f] : ComponentView<int, float>(ints, floats)) {
+		CHECK(i == (int)f);
+		CHECK(&i == &ints.get(e) && &f == &floats.get(e));
+		visited++;
+	}
+	CHECK(visited == floats.size());
+
+	// Driven by floats again, now the first container, and entities without an int are skipped
+	ints.remove(entities[4]);
+	visited = 0;
+	for (auto [e, f, i] : ComponentView<float, int>(floats, ints)) {
+		CHECK(e.id() != entities[4].id());
+		CHECK(i == (int)f);
+		visited++;
+	}
+	CHECK(visited == floats.size() - 1);
+
+	for (Entity e : entities)
+		Entity::release(e);
+}
+
+int main() {
+	test_stale_handle_after_reuse();
+	test_free_list_depth();
+	test_remove_batch();
+	test_view();
+	return test_result();
+}
@@ -0,0 +1,153 @@
+// FlowField::update must give the same distances as a field built from scratch, whatever fire blocks come and go
+#define GL3W_IMPLEMENTATION
+#include <gl3w.h>
+
+#include <random>
+
+#include "pathing.hpp"
+#include "tinyECS/registry.hpp"
+#include "test.hpp"
+
+// Same passability rules as AISystem::isOccupied and AISystem::isOccupiedSansFire
+static bool isOccupied(ivec2 pos) {
+	return registry.grid.any({ pos.x, pos.y }, BLOCKING_GRID_LAYERS);
+}
+static bool isOccupiedSansFire(ivec2 pos) {
+	return registry.grid.has({ pos.x, pos.y }, GRID_LAYER::OBSTACLE);
+}
+
+// Compares every cell of the repaired field with a fresh one, returns false on the first mismatch
+static bool matches_fresh_field(const FlowField& field, bool (*isCellOccupied)(ivec2), ivec2 target) {
+	FlowField fresh(isCellOccupied);
+	fresh.update(target);
+	for (int y = 0; y < registry.grid.rows(); y++)
+		for (int x = 0; x < registry.grid.cols(); x++)
+			if (field.distanceAt({ x, y }) != fresh.distanceAt({ x, y }))
+				return false;
+	return true;
+}
+
+// Toggles fire on random cells of a random map, a few cells between updates, and moves the target now and then
+static void test_random_fire_toggles(unsigned int seed, int rows, int cols, int toggles) {
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> random_x(0, cols - 1), random_y(0, rows - 1);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+	registry.grid.resize(rows, cols);
+	Entity wall;
+	for (int y = 0; y < rows; y++)
+		for (int x = 0; x < cols; x++)
+			if (unit(rng) < 0.2f)
+				registry.grid.set({ x, y }, GRID_LAYER::OBSTACLE, wall);
+
+	FlowField walking_field(isOccupied);
+	FlowField fire_walking_field(isOccupiedSansFire);
+	ivec2 target = { random_x(rng), random_y(rng) };
+	walking_field.update(target);
+	fire_walking_field.update(target);
+
+	Entity fire;
+	int mismatches = 0;
+	for (int toggle = 0; toggle < toggles;) {
+		int batch = 1 + (int)(rng() % 4);
+		for (int k = 0; k < batch; k++, toggle++) {
+			std::pair<int, int> cell = { random_x(rng), random_y(rng) };
+			if (registry.grid.has(cell, GRID_LAYER::FIRE))
+				registry.grid.unset(cell, GRID_LAYER::FIRE);
+			else
+				registry.grid.set(cell, GRID_LAYER::FIRE, fire);
+		}
+		if (unit(rng) < 0.05f)
+			target = { random_x(rng), random_y(rng) };
+
+		walking_field.update(target);
+		fire_walking_field.update(target);
+		if (!matches_fresh_field(walking_field, isOccupied, target) ||
+			!matches_fresh_field(fire_walking_field, isOccupiedSansFire, target))
+			mismatches++;
+	}
+	CHECK(mismatches == 0);
+	Entity::release(wall);
+	Entity::release(fire);
+}
+
+// Steps read from the field lead to the target in exactly distanceAt steps
+static void test_next_step_follows_distance() {
+	registry.grid.resize(9, 9);
+	Entity wall;
+	for (int y = 1; y < 8; y++)
+		registry.grid.set({ 4, y }, GRID_LAYER::OBSTACLE, wall);
+
+	FlowField field(isOccupied);
+	ivec2 target = { 8, 4 };
+	field.update(target);
+
+	ivec2 cell = { 0, 4 };
+	uint steps = 0;
+	ivec2 next;
+	while (field.nextStep(cell, next)) {
+		CHECK(field.distanceAt(next) + 1 == field.distanceAt(cell));
+		cell = next;
+		steps++;
+	}
+	CHECK(cell == target);
+	CHECK(steps == field.distanceAt({ 0, 4 }));
+	CHECK(steps == 16);	// around the wall through row 0 or row 8
+
+	// Walled in completely
+	registry.grid.set({ 4, 0 }, GRID_LAYER::OBSTACLE, wall);
+	registry.grid.set({ 4, 8 }, GRID_LAYER::OBSTACLE, wall);
+	field.update(target);
+	CHECK(field.distanceAt({ 0, 4 }) == FlowField::UNREACHABLE);
+	CHECK(!field.nextStep({ 0, 4 }, next));
+	Entity::release(wall);
+}
+
+// PathSearch finds paths as short as the flow field's distances, made of free neighboring cells
+static void test_path_search_matches_field(unsigned int seed, int rows, int cols, int searches) {
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> random_x(0, cols - 1), random_y(0, rows - 1);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+	registry.grid.resize(rows, cols);
+	Entity wall;
+	for (int y = 0; y < rows; y++)
+		for (int x = 0; x < cols; x++)
+			if (unit(rng) < 0.25f)
+				registry.grid.set({ x, y }, GRID_LAYER::OBSTACLE, wall);
+
+	PathSearch search;
+	FlowField field(isOccupied);
+	std::vector<ivec2> path;
+	int mismatches = 0;
+	for (int i = 0; i < searches; i++) {
+		ivec2 start = { random_x(rng), random_y(rng) };
+		ivec2 goal = { random_x(rng), random_y(rng) };
+		if (isOccupied(start)) continue;
+		field.update(goal);
+
+		bool found = search.findPath(start, goal, isOccupied, path);
+		uint distance = field.distanceAt(start);
+		if (!found) {
+			mismatches += distance != FlowField::UNREACHABLE;
+			continue;
+		}
+		bool valid = path.front() == goal && path.back() == start && path.size() == distance + 1;
+		for (size_t k = 1; k < path.size(); k++) {
+			ivec2 step = glm::abs(path[k] - path[k - 1]);
+			valid &= step.x + step.y == 1 && !isOccupied(path[k]);
+		}
+		mismatches += !valid;
+	}
+	CHECK(mismatches == 0);
+	Entity::release(wall);
+}
+
+int main() {
+	test_next_step_follows_distance();
+	test_random_fire_toggles(1, 12, 16, 5000);
+	test_random_fire_toggles(2, 30, 40, 5000);
+	test_random_fire_toggles(3, 5, 5, 2000);
+	test_path_search_matches_field(4, 30, 40, 2000);
+	return test_result();
+}
@@ -0,0 +1,124 @@
+// The broadphase must report exactly the collisions of the old all-pairs pass
+#define GL3W_IMPLEMENTATION
+#include <gl3w.h>
+
+#include <random>
+#include <set>
+
+#include "physics_system.hpp"
+#include "test.hpp"
+
+using CollisionSet = std::set<std::pair<unsigned int, unsigned int>>;
+
+// Collisions recorded by the last step, each pair with the lower id first
+static CollisionSet recorded_collisions() {
+	CollisionSet collisions;
+	for (size_t k = 0; k < registry.collisions.size(); k++) {
+		unsigned int a = registry.collisions.entities[k].id();
+		unsigned int b = registry.collisions.components[k].other.id();
+		collisions.insert({ std::min(a, b), std::max(a, b) });
+	}
+	// Every pair is reported once
+	CHECK(collisions.size() == registry.collisions.size());
+	return collisions;
+}
+
+// The collision pass before the broadphase: collides() on every pair of collidable motions. Pairs of layers that do not
+// collide and static/static pairs are dropped, as PhysicsSystem does.
+static CollisionSet all_pairs_collisions(const PhysicsSystem& physics) {
+	CollisionSet collisions;
+	ComponentContainer<Motion>& motions = registry.motions;
+	for (size_t i = 0; i < motions.size(); i++) {
+		const Motion& motion_i = motions.components[i];
+		if (!motion_i.collidable) continue;
+		for (size_t j = i + 1; j < motions.size(); j++) {
+			const Motion& motion_j = motions.components[j];
+			if (!motion_j.collidable || !physics.layersCollide(motion_i.collision_layer, motion_j.collision_layer)) continue;
+			if (registry.staticBodies.has(motions.entities[i]) && registry.staticBodies.has(motions.entities[j])) continue;
+			if (collides(motion_i, motion_j)) {
+				unsigned int a = motions.entities[i].id(), b = motions.entities[j].id();
+				collisions.insert({ std::min(a, b), std::max(a, b) });
+			}
+		}
+	}
+	return collisions;
+}
+
+// Bodies scattered over spread x spread cells. Half of them sit on cell centers with cell sized hitboxes,
+// so exactly touching boxes and boxes ending on bucket borders are common.
+static void create_bodies(std::mt19937& rng, int count, int spread, bool layers, bool statics) {
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	std::uniform_int_distribution<int> cell(0, spread - 1);
+	for (int i = 0; i < count; i++) {
+		Entity entity;
+		Motion& motion = registry.motions.emplace(entity);
+		motion.collidable = unit(rng) < 0.9f;
+		if (unit(rng) < 0.5f) {
+			motion.position = grid_coords_to_position(cell(rng), cell(rng));
+			motion.hitbox = { GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX };
+		} else {
+			motion.position = { unit(rng) * spread * GRID_CELL_WIDTH_PX, unit(rng) * spread * GRID_CELL_HEIGHT_PX };
+			motion.hitbox = { unit(rng) * 2.5f * GRID_CELL_WIDTH_PX, unit(rng) * 2.5f * GRID_CELL_HEIGHT_PX };
+			if (unit(rng) < 0.05f)
+				motion.hitbox.x = 0.f;	// never collides
+		}
+		motion.scale = motion.hitbox;
+		if (layers)
+			motion.collision_layer = (COLLISION_LAYER)(rng() % collision_layer_count);
+		if (statics && unit(rng) < 0.3f)
+			registry.staticBodies.emplace(entity);
+	}
+}
+
+static void clear_bodies() {
+	std::vector<Entity> entities = registry.motions.entities;
+	for (Entity e : entities)
+		registry.destroy_entity(e);
+	registry.collisions.clear();
+}
+
+static void check_step(PhysicsSystem& physics) {
+	registry.collisions.clear();
+	physics.step(0.f);
+	CHECK(recorded_collisions() == all_pairs_collisions(physics));
+}
+
+int main() {
+	std::mt19937 rng(1234);
+
+	// Default layers, no static geometry: the plain all-pairs pass of the original code
+	for (int count : { 0, 1, 2, 50, 1000 }) {
+		PhysicsSystem physics;
+		create_bodies(rng, count, 12, false, false);
+		check_step(physics);
+		clear_bodies();
+	}
+
+	// Layers and static geometry, with the dynamic bodies moved between steps while the cached static buckets stay
+	for (int spread : { 4, 20, 60 }) {
+		PhysicsSystem physics;
+		create_bodies(rng, 2000, spread, true, true);
+		check_step(physics);
+		std::uniform_real_distribution<float> offset(-GRID_CELL_WIDTH_PX, GRID_CELL_WIDTH_PX);
+		for (size_t i = 0; i < registry.motions.size(); i++)
+			if (!registry.staticBodies.has(registry.motions.entities[i]))
+				registry.motions.components[i].position += vec2(offset(rng), offset(rng));
+		check_step(physics);
+
+		// New static geometry, as when the next level is loaded
+		create_bodies(rng, 200, spread, true, true);
+		check_step(physics);
+		clear_bodies();
+	}
+
+	// A few bodies far outside the map make the bucket grid too large, the broadphase falls back to testing all pairs
+	{
+		PhysicsSystem physics;
+		create_bodies(rng, 500, 10, true, true);
+		create_bodies(rng, 5, 5000, true, true);
+		check_step(physics);
+		clear_bodies();
+	}
+
+	return test_result();
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <iostream>
+
+// Minimal checks for the test executables, they stay active in release builds unlike assert
+static int test_failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl; \
+			test_failures++; \
+		} \
+	} while (false)
+
+// Return value of main, non-zero makes ctest report the test as failed
+inline int test_result() {
+	if (test_failures == 0)
+		std::cout << "all checks passed" << std::endl;
+	return test_failures == 0 ? 0 : 1;
+}